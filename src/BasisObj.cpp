@@ -1,13 +1,15 @@
 #include "BasisObj.h"
+#include "FdCache.h"
+#include "helpers.h"
+#include "Trace.h"
+
+using fdpot::Trace;
 
 FdHandler<BasisEnum::BSPLINE>::FdHandler(
     splines2::BSpline && bspline_basis):basis(std::move(bspline_basis)), N(21), quad(Simpson(), Mesh1D(Domain1D(0,1), N)),
     keep_bases_(basis.get_spline_df()){
-#ifndef MYNDEBUG
-  std::cout << "Constructing the basis handler" << std::endl;
-  std::cout << "N nodes " << N << std::endl;
-  std::cout << "number of bases " << keep_bases_ << std::endl;
-#endif
+  Trace::event(Trace::Level::DEBUG, "basis_handler", "quad_nodes", N,
+               "n_bases", keep_bases_);
   
   arma::vec a_b = this->basis.get_boundary_knots();
   this->domain = Domain1D(a_b[0], a_b[1]);
@@ -27,48 +29,89 @@ double FdHandler<BasisEnum::BSPLINE>::operator()(const arma::mat& coef,
 
 arma::mat FdHandler<BasisEnum::BSPLINE>::compute_dissim_matrix(
     const arma::mat& X_coef){
-  arma::mat dis_mat = arma::mat(X_coef.n_cols, X_coef.n_cols);
-#ifndef MYNDEBUG
-  std::cout << "Computing dissimilarity matrix" << std::endl;
-#endif	
+  const auto& cache = fdpot::FdCache::global();
+  std::uint64_t key = 0;
+  arma::mat dis_mat;
+  if (cache != nullptr){
+    key = this->cache_key(X_coef, "d0.L2");  // the only similarity method
+    if (cache->load(key, dis_mat)){
+      Trace::event(Trace::Level::INFO, "dissim_matrix.cached", "n", X_coef.n_cols);
+      return dis_mat;
+    }
+  }
+  Trace::Span span(Trace::Level::INFO, "dissim_matrix", "n", X_coef.n_cols);
+  dis_mat = arma::mat(X_coef.n_cols, X_coef.n_cols, arma::fill::zeros);
   
 #if defined(PARALLELO) && defined(_OPENMP)
-  int threads = omp_get_num_threads();
-  Rcpp::Rcout << "open mp active. n threads recognised by default: " << threads << std::endl;
-  Rcpp::Rcout << "note this package has 1 threads hardcoded if openmp enabled" << std::endl;
+  // note this package has 1 thread hardcoded if openmp enabled
+  Trace::event(Trace::Level::DEBUG, "dissim_matrix.threads", "default", omp_get_num_threads(),
+               "used", 1);
 #pragma omp parallel for collapse(2) num_threads(1)
 #endif
   for (unsigned i = 0; i < X_coef.n_cols; i++){
-    #ifndef MYNDEBUG
-        std::cout << "Column " << i << " of " << X_coef.n_cols<< std::endl;
-    #endif
     for (unsigned j = i+1; j < X_coef.n_cols; j++){
       dis_mat(i,j) = quad.apply([this, i,j, &X_coef](double t)-> double{
         return ((*this)(X_coef, i, t) - (*this)(X_coef, j, t) )*((*this)(X_coef, i, t) - (*this)(X_coef, j, t) );
       }
       );
       dis_mat(j,i) = dis_mat(i,j); 
-      #ifndef MYNDEBUG
-            std::cout << "(i,j); " << i << " , "<< j << " is " << dis_mat(i,j)<< std::endl;
-      #endif
+      Trace::event(Trace::Level::VERBOSE, "dissim_matrix.entry", "i", i, "j", j,
+                   "value", dis_mat(i,j));
     }
     
   }
+  if (cache != nullptr)
+    cache->store(key, dis_mat);
   return dis_mat;
 }; 
 
 
+void FdHandler<BasisEnum::BSPLINE>::extend_dissim_matrix(
+    arma::mat& dissim, const arma::mat& X_coef){
+  const unsigned n_old = dissim.n_rows;
+  // resize keeps the old block and zeroes the new one (the diagonal included)
+  dissim.resize(X_coef.n_cols, X_coef.n_cols);
+  for (unsigned i = n_old; i < X_coef.n_cols; i++){
+    for (unsigned j = 0; j < i; j++){
+      dissim(i,j) = quad.apply([this, i,j, &X_coef](double t)-> double{
+        return ((*this)(X_coef, i, t) - (*this)(X_coef, j, t) )*((*this)(X_coef, i, t) - (*this)(X_coef, j, t) );
+      }
+      );
+      dissim(j,i) = dissim(i,j);
+    }
+  }
+}
+
 arma::mat FdHandler<BasisEnum::BSPLINE>::compute_features(
     const arma::mat & X_coef, unsigned n_feats){
-#ifndef MYNDEBUG
-  std::cout << "Computing features with n_feats = " << n_feats << std::endl;
-#endif
+  const auto& cache = fdpot::FdCache::global();
+  std::uint64_t key = 0;
+  arma::mat feats;
+  if (cache != nullptr){
+    key = this->cache_key(X_coef, "features", n_feats);
+    if (cache->load(key, feats)){
+      Trace::event(Trace::Level::INFO, "features.cached", "n_feats", n_feats);
+      return feats;
+    }
+  }
+  Trace::Span span(Trace::Level::INFO, "features", "n", X_coef.n_cols, "n_feats", n_feats);
   this->compute_basis_integrals(n_feats);
   
   // X_coef is df x n_samples ;
   // basis integrals is df x features
   // returns a matrix of n_samples * n_feats
-  return  X_coef.t() * this->basis_integrals;
+  feats = X_coef.t() * this->basis_integrals;
+  if (cache != nullptr)
+    cache->store(key, feats);
+  return feats;
+}
+
+arma::fmat FdHandler<BasisEnum::BSPLINE>::compute_features_single(
+    const arma::mat & X_coef, unsigned n_feats){
+  this->compute_basis_integrals(n_feats);
+  
+  return arma::conv_to<arma::fmat>::from(X_coef.t()) * 
+    arma::conv_to<arma::fmat>::from(this->basis_integrals);
 }
 
 
@@ -80,9 +123,8 @@ void FdHandler<BasisEnum::BSPLINE>::compute_basis_integrals(unsigned n_feats){
   for (unsigned j = 0; j < n_feats; j++){
     double lb = this->domain.left() + j*I / (n_feats);
     double up = this->domain.left() + (j+1)*I/ (n_feats); 
-#ifndef MYNDEBUG
-    std::cout << "Current lb, up of integration for bases are: " << lb << " " << up << std::endl;
-#endif
+    Trace::event(Trace::Level::DEBUG, "basis_integrals.interval", "feature", j,
+                 "lb", lb, "up", up);
     auto weight_basis = [lb, up](double const&x) -> double{
       return (x < up and x>= lb) ? 1 : 0;  // step function
     };
@@ -98,10 +140,22 @@ void FdHandler<BasisEnum::BSPLINE>::compute_basis_integrals(unsigned n_feats){
           return weight_basis(t) * this->basis_function(k)(t);  // dot product
         }
       );
-#ifndef MYNDEBUG
-      std::cout << "Basis integral for basis " << k << ", feature " << j << \
-        "is " << basis_integrals(k, j) << std::endl;
-#endif
+      Trace::event(Trace::Level::VERBOSE, "basis_integrals.entry", "basis", k,
+                   "feature", j, "value", basis_integrals(k, j));
     }
   }
 }
+
+std::uint64_t FdHandler<BasisEnum::BSPLINE>::cache_key(
+    const arma::mat& X_coef, const std::string& what, const unsigned n_feats){
+  const arma::vec knots = arma::join_cols(this->basis.get_internal_knots(),
+                                          this->basis.get_boundary_knots());
+  const arma::vec params{static_cast<double>(this->basis.get_degree()),
+    static_cast<double>(this->keep_bases_), static_cast<double>(this->N),
+    static_cast<double>(n_feats), static_cast<double>(X_coef.n_rows),
+    static_cast<double>(X_coef.n_cols)};
+  std::uint64_t key = helpers::fnv1a(what.data(), what.size());
+  key = helpers::fnv1a(params.memptr(), params.n_elem * sizeof(double), key);
+  key = helpers::fnv1a(knots.memptr(), knots.n_elem * sizeof(double), key);
+  return helpers::fnv1a(X_coef.memptr(), X_coef.n_elem * sizeof(double), key);
+}
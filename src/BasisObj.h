@@ -1,6 +1,8 @@
 #ifndef BASIS_OBJ_HH
 #define BASIS_OBJ_HH
 
+#include <cstdint>
+#include <string>
 #include <splines2Armadillo.h>
 
 // for integration
@@ -91,6 +93,18 @@ public:
  */
   arma::mat compute_dissim_matrix(const arma::mat& X_coef);
   
+  // NB compute_dissim_matrix and compute_features read and write the cache
+  // of the session, if any (see fdpot::FdCache)
+  
+  /*! @brief Extends a dissimilarity matrix with new functional data
+   Only the dissimilarities of the new data (with the old ones and among
+   themselves) are computed: O(n_new * n) integrals instead of O(n^2)
+   @param dissim the dissimilarity matrix of the first dissim.n_rows columns
+   of X_coef, resized to n_samples x n_samples in place
+   @param X_coef the coefficients of all the data, the old ones first
+ */
+  void extend_dissim_matrix(arma::mat& dissim, const arma::mat& X_coef);
+  
  /*! @brief Compute the features from functional data
    Performs the dot product of the functions with step functions.
    Once the integrals of the bases * step functions are obtained, the dot product of that value
@@ -102,6 +116,25 @@ public:
  */
   arma::mat compute_features(const arma::mat & X_coef, unsigned n_feats);
   
+ /*! @brief Single precision version of compute_features
+   The integrals of the bases are still computed in double precision; only
+   the product with the coefficients and the result are in float.
+   
+   @param X_coef the coefficient matrix
+   @param n_feats how many features
+   @return the n_samples x n_feats matrix of features in single precision
+ */
+  arma::fmat compute_features_single(const arma::mat & X_coef, unsigned n_feats);
+  
+  /*! @brief Key of a result of these data (see fdpot::FdCache and
+   fdpot::Checkpoint)
+   Hashes the coefficients, the knots and the degree of the basis, the
+   quadrature nodes, the kind of result and the number of features
+   @param what the kind of result, e.g. the similarity method
+   */
+  std::uint64_t cache_key(const arma::mat& X_coef, const std::string& what,
+                          const unsigned n_feats = 0);
+  
 private:
   // members
   double a, b;
@@ -0,0 +1,156 @@
+#include "BoundedNLP.h"
+#include <algorithm>
+#include <sstream>
+
+#include "IpSolveStatistics.hpp"
+
+namespace fdpot{
+
+bool BoundedNLP::get_bounds_info(Index n_, Number* x_l, Number* x_u,
+                                 Index m_, Number* g_l, Number* g_u){
+  for (Index j = 0; j < n_; j++){
+    x_l[j] = this->xl[j];
+    x_u[j] = this->xu[j];
+  }
+  for (Index i = 0; i < m_; i++){
+    g_l[i] = this->gl[i];
+    g_u[i] = this->gu[i];
+  }
+  return true;
+}
+
+bool BoundedNLP::get_starting_point(Index n_, bool init_x, Number* x,
+                                    bool init_z, Number* z_L, Number* z_U,
+                                    Index m_, bool init_lambda, Number* lambda){
+  // the multipliers are available only for a warm start
+  if ((init_z and (this->zl0 == nullptr or this->zu0 == nullptr)) or
+      (init_lambda and this->lambda0 == nullptr))
+    return false;
+  if (init_x)
+    for (Index j = 0; j < n_; j++)
+      x[j] = this->x0[j];
+  if (init_z)
+    for (Index j = 0; j < n_; j++){
+      z_L[j] = (*this->zl0)[j];
+      z_U[j] = (*this->zu0)[j];
+    }
+  if (init_lambda)
+    for (Index i = 0; i < m_; i++)
+      lambda[i] = (*this->lambda0)[i];
+  return true;
+}
+
+bool BoundedNLP::intermediate_callback(Ipopt::AlgorithmMode mode, Index iter,
+                                       Number obj_value, Number inf_pr,
+                                       Number inf_du, Number mu, Number d_norm,
+                                       Number regularization_size, Number alpha_du,
+                                       Number alpha_pr, Index ls_trials,
+                                       const Ipopt::IpoptData* ip_data,
+                                       Ipopt::IpoptCalculatedQuantities* ip_cq){
+  if (this->log != nullptr){
+    this->log->iterations = iter;
+    this->log->inf_pr = inf_pr;
+    this->log->mu = mu;
+  }
+  // false stops Ipopt
+  return this->iter_budget < 0 or iter < this->iter_budget;
+}
+
+void BoundedNLP::finalize_solution(Ipopt::SolverReturn status, Index n_,
+                                   const Number* x, const Number* z_L,
+                                   const Number* z_U, Index m_, const Number* g,
+                                   const Number* lambda, Number obj_value,
+                                   const Ipopt::IpoptData* ip_data,
+                                   Ipopt::IpoptCalculatedQuantities* ip_cq){
+  // written in place: the vectors of a handler solved again (e.g. in the
+  // rounds of a race) keep their memory
+  auto copy_into = [](Dvector& v, const Number* values, const Index size){
+    v.set_size(size);
+    std::copy(values, values + size, v.memptr());
+  };
+  this->solution.status = to_solve_result_status(status);
+  copy_into(this->solution.x, x, n_);
+  copy_into(this->solution.zl, z_L, n_);
+  copy_into(this->solution.zu, z_U, n_);
+  copy_into(this->solution.g, g, m_);
+  copy_into(this->solution.lambda, lambda, m_);
+  this->solution.obj_value = obj_value;
+}
+
+bool apply_ipopt_options(const std::string& options, Ipopt::IpoptApplication& app){
+  std::istringstream lines(options);
+  std::string line;
+  bool ok = true;
+
+  while (std::getline(lines, line)){
+    std::istringstream words(line);
+    std::string type, name, value;
+    if (not (words >> type >> name >> value))
+      continue;  // empty line
+
+    if (type == "String")
+      ok &= app.Options()->SetStringValue(name, value);
+    else if (type == "Integer")
+      ok &= app.Options()->SetIntegerValue(name, std::stoi(value));
+    else if (type == "Numeric")
+      ok &= app.Options()->SetNumericValue(name, std::stod(value));
+    else
+      ok = false;
+  }
+  return ok;
+}
+
+CppAD::ipopt::solve_result<arma::vec>::status_type
+  to_solve_result_status(Ipopt::SolverReturn status){
+  using result = CppAD::ipopt::solve_result<arma::vec>;
+  switch (status){
+    case Ipopt::SUCCESS: return result::success;
+    case Ipopt::MAXITER_EXCEEDED: return result::maxiter_exceeded;
+    case Ipopt::STOP_AT_TINY_STEP: return result::stop_at_tiny_step;
+    case Ipopt::STOP_AT_ACCEPTABLE_POINT: return result::stop_at_acceptable_point;
+    case Ipopt::LOCAL_INFEASIBILITY: return result::local_infeasibility;
+    case Ipopt::USER_REQUESTED_STOP: return result::user_requested_stop;
+    case Ipopt::FEASIBLE_POINT_FOUND: return result::feasible_point_found;
+    case Ipopt::DIVERGING_ITERATES: return result::diverging_iterates;
+    case Ipopt::RESTORATION_FAILURE: return result::restoration_failure;
+    case Ipopt::ERROR_IN_STEP_COMPUTATION: return result::error_in_step_computation;
+    case Ipopt::INVALID_NUMBER_DETECTED: return result::invalid_number_detected;
+    case Ipopt::TOO_FEW_DEGREES_OF_FREEDOM: return result::too_few_degrees_of_freedom;
+    case Ipopt::INTERNAL_ERROR: return result::internal_error;
+    default: return result::unknown;
+  }
+}
+
+std::string status_name(CppAD::ipopt::solve_result<arma::vec>::status_type status){
+  using result = CppAD::ipopt::solve_result<arma::vec>;
+  switch (status){
+    case result::not_defined: return "not_defined";
+    case result::success: return "success";
+    case result::maxiter_exceeded: return "maxiter_exceeded";
+    case result::stop_at_tiny_step: return "stop_at_tiny_step";
+    case result::stop_at_acceptable_point: return "stop_at_acceptable_point";
+    case result::local_infeasibility: return "local_infeasibility";
+    case result::user_requested_stop: return "user_requested_stop";
+    case result::feasible_point_found: return "feasible_point_found";
+    case result::diverging_iterates: return "diverging_iterates";
+    case result::restoration_failure: return "restoration_failure";
+    case result::error_in_step_computation: return "error_in_step_computation";
+    case result::invalid_number_detected: return "invalid_number_detected";
+    case result::too_few_degrees_of_freedom: return "too_few_degrees_of_freedom";
+    case result::internal_error: return "internal_error";
+    default: return "unknown";
+  }
+}
+
+SolveCounts counts_of(Ipopt::IpoptApplication& app){
+  SolveCounts counts;
+  Ipopt::SmartPtr<Ipopt::SolveStatistics> stats = app.Statistics();
+  if (not Ipopt::IsValid(stats))
+    return counts;
+  counts.iterations = stats->IterationCount();
+  stats->NumberOfEvaluations(counts.obj_evals, counts.constr_evals, counts.grad_evals,
+                             counts.jac_evals, counts.hess_evals);
+  return counts;
+}
+
+} // namespace fdpot
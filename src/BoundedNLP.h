@@ -0,0 +1,145 @@
+#ifndef BOUNDED_NLP_HH
+#define BOUNDED_NLP_HH
+#include <cppad/ipopt/solve.hpp>
+#include <string>
+
+#include "IpTNLP.hpp"
+#include "IpIpoptApplication.hpp"
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief What the intermediate callback saw at the last iteration of a solve */
+struct IterationLog{
+  /*! @brief iterations done (the starting point is iteration 0) */
+  int iterations = 0;
+  /*! @brief primal infeasibility of the last iterate */
+  double inf_pr = 0.;
+  /*! @brief barrier parameter of the last iterate, to warm start from it */
+  double mu = 0.;
+};
+
+/*! @brief Work done by the solves of a restart, summed over its solves
+ (e.g. the rounds of a race)
+ */
+struct SolveCounts{
+  int iterations = 0;  // Ipopt iterations (epochs of the stochastic backend)
+  int obj_evals = 0, constr_evals = 0;  // evaluations of f and g
+  int grad_evals = 0, jac_evals = 0, hess_evals = 0;  // of their derivatives
+
+  inline SolveCounts& operator+=(const SolveCounts& other){
+    this->iterations += other.iterations;
+    this->obj_evals += other.obj_evals;
+    this->constr_evals += other.constr_evals;
+    this->grad_evals += other.grad_evals;
+    this->jac_evals += other.jac_evals;
+    this->hess_evals += other.hess_evals;
+    return *this;
+  }
+};
+
+/*! @brief Base of the Ipopt problems of this package
+
+ @description Deals with everything that does not depend on how the 
+ functions and their derivatives are evaluated: bounds, starting point and
+ solution. The solution is written in the same solve_result that CppAD 
+ uses, so that the OptimHandler keeps its interface.
+ */
+class BoundedNLP: public Ipopt::TNLP{
+public:
+  using Index = Ipopt::Index;
+  using Number = Ipopt::Number;
+  using Dvector = arma::vec;
+
+  /*! @brief Constructor
+   @param x0_ the starting point
+   @param xl_, xu_ bounds of the variables
+   @param gl_, gu_ bounds of the constraints
+   @param solution_ where to store the solution (not owned)
+   */
+  BoundedNLP(const Dvector& x0_,
+             const Dvector& xl_, const Dvector& xu_,
+             const Dvector& gl_, const Dvector& gu_,
+             CppAD::ipopt::solve_result<Dvector>& solution_):
+    x0(x0_), xl(xl_), xu(xu_), gl(gl_), gu(gu_),
+    solution(solution_), n(x0_.n_elem), m(gl_.n_elem) {};
+
+  /*! @brief Sets the starting multipliers, for a warm start
+   Ipopt asks for them only with the option warm_start_init_point yes.
+   @param zl_, zu_ multipliers of the bounds of the variables (not owned)
+   @param lambda_ multipliers of the constraints (not owned)
+   */
+  inline void set_multipliers(const Dvector& zl_, const Dvector& zu_,
+                              const Dvector& lambda_){
+    this->zl0 = &zl_;
+    this->zu0 = &zu_;
+    this->lambda0 = &lambda_;
+  }
+
+  /*! @brief Logs the iterations and stops the solve after a budget
+   With a budget, Ipopt stops with USER_REQUESTED_STOP and the last iterate
+   (and its multipliers) is stored in the solution, so that the solve can be
+   continued with a warm start.
+   @param log_ where to log (not owned)
+   @param budget_ maximum number of iterations, negative for no limit
+   */
+  inline void track_iterations(IterationLog& log_, const int budget_ = -1){
+    this->log = &log_;
+    this->iter_budget = budget_;
+  }
+
+  bool intermediate_callback(Ipopt::AlgorithmMode mode, Index iter, Number obj_value,
+                             Number inf_pr, Number inf_du, Number mu, Number d_norm,
+                             Number regularization_size, Number alpha_du,
+                             Number alpha_pr, Index ls_trials,
+                             const Ipopt::IpoptData* ip_data,
+                             Ipopt::IpoptCalculatedQuantities* ip_cq) override;
+
+  bool get_bounds_info(Index n_, Number* x_l, Number* x_u,
+                       Index m_, Number* g_l, Number* g_u) override;
+
+  bool get_starting_point(Index n_, bool init_x, Number* x,
+                          bool init_z, Number* z_L, Number* z_U,
+                          Index m_, bool init_lambda, Number* lambda) override;
+
+  void finalize_solution(Ipopt::SolverReturn status, Index n_, const Number* x,
+                         const Number* z_L, const Number* z_U, Index m_,
+                         const Number* g, const Number* lambda, Number obj_value,
+                         const Ipopt::IpoptData* ip_data,
+                         Ipopt::IpoptCalculatedQuantities* ip_cq) override;
+
+protected:
+  const Dvector &x0, &xl, &xu, &gl, &gu;
+  CppAD::ipopt::solve_result<Dvector>& solution;
+  const size_t n, m;
+  const Dvector *zl0 = nullptr, *zu0 = nullptr, *lambda0 = nullptr;
+  IterationLog* log = nullptr;
+  int iter_budget = -1;
+};
+
+/*! @brief Applies an options string to an Ipopt application
+
+ The string has the same format of the one of CppAD::ipopt::solve, i.e. one
+ option per line given as "type name value" where type is one of String,
+ Integer, Numeric.
+ @param options the options string
+ @param app the Ipopt application
+ @return false if one of the options was not accepted by Ipopt
+ */
+bool apply_ipopt_options(const std::string& options, Ipopt::IpoptApplication& app);
+
+/*! @brief Converts the return status of Ipopt to the one of CppAD */
+CppAD::ipopt::solve_result<arma::vec>::status_type
+  to_solve_result_status(Ipopt::SolverReturn status);
+
+/*! @brief Name of a CppAD solve status, e.g. "success" */
+std::string status_name(CppAD::ipopt::solve_result<arma::vec>::status_type status);
+
+/*! @brief The iterations and evaluations of the last solve of an application
+ (zero if it has no statistics, e.g. it failed before solving)
+ */
+SolveCounts counts_of(Ipopt::IpoptApplication& app);
+
+} // namespace fdpot
+
+#endif
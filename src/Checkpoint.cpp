@@ -0,0 +1,145 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "helpers.h"
+
+namespace fdpot{
+
+namespace {
+const char magic[8] = {'F', 'D', 'P', 'O', 'T', 'C', 'K', 'P'};
+const std::uint32_t version = 2;
+
+/*! @brief Opens a checkpoint file and checks its header
+ @return whether the file exists and belongs to key
+ */
+bool open_for(const std::string& file, const std::uint64_t key, std::ifstream& in){
+  in.open(file, std::ios::binary);
+  if (not in)
+    return false;
+  char file_magic[8];
+  std::uint32_t file_version = 0;
+  std::uint64_t file_key = 0;
+  in.read(file_magic, sizeof(file_magic));
+  in.read(reinterpret_cast<char*>(&file_version), sizeof(file_version));
+  in.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+  return in and std::memcmp(file_magic, magic, sizeof(magic)) == 0 and
+    file_version == version and file_key == key;
+}
+
+/*! @brief Writes the header and the objects to a temporary file, then
+ replaces the checkpoint with it
+ @param write writes the objects to the stream, returns false on failure
+ */
+template<typename WriteT>
+void write_atomically(const std::string& file, const std::uint64_t key, WriteT write){
+  const std::string tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    if (not out or not write(out) or not out.flush())
+      Rcpp::stop("cannot write the checkpoint " + tmp);
+  }
+  if (std::rename(tmp.c_str(), file.c_str()) != 0)
+    Rcpp::stop("cannot replace the checkpoint " + file);
+}
+} // anonymous namespace
+
+std::uint64_t Checkpoint::key_of(const arma::mat& data, const arma::vec& params,
+                                 const std::uint64_t hash){
+  const arma::uword dims[2] = {data.n_rows, data.n_cols};
+  std::uint64_t key = helpers::fnv1a(dims, sizeof(dims), hash);
+  key = helpers::fnv1a(data.memptr(), data.n_elem * sizeof(double), key);
+  return helpers::fnv1a(params.memptr(), params.n_elem * sizeof(double), key);
+}
+
+bool Checkpoint::load_data(const std::uint64_t key, arma::mat& raw_features,
+                           arma::mat& dissim) const{
+  std::ifstream in;
+  if (not open_for(this->path + ".data", key, in))
+    return false;
+  arma::mat feats, diss;
+  if (not feats.load(in, arma::arma_binary) or not diss.load(in, arma::arma_binary))
+    return false;
+  raw_features = std::move(feats);
+  dissim = std::move(diss);
+  return true;
+}
+
+void Checkpoint::save_data(const std::uint64_t key, const arma::mat& raw_features,
+                           const arma::mat& dissim) const{
+  write_atomically(this->path + ".data", key, [&](std::ostream& out){
+    return raw_features.save(out, arma::arma_binary) and dissim.save(out, arma::arma_binary);
+  });
+}
+
+bool Checkpoint::load_restarts(const std::uint64_t key, FdPotResults& results,
+                               arma::uvec& done) const{
+  std::ifstream in;
+  if (not open_for(this->path, key, in))
+    return false;
+  arma::uvec file_done, seeds, has_multipliers, n_active_weights;
+  arma::vec obj, cost, penalty, seconds;
+  arma::mat vars, zl, zu, lambda;
+  arma::Mat<int> evaluations;
+  arma::Col<int> status;
+  const bool read = file_done.load(in, arma::arma_binary) and seeds.load(in, arma::arma_binary) and
+    vars.load(in, arma::arma_binary) and zl.load(in, arma::arma_binary) and
+    zu.load(in, arma::arma_binary) and lambda.load(in, arma::arma_binary) and
+    has_multipliers.load(in, arma::arma_binary) and obj.load(in, arma::arma_binary) and
+    cost.load(in, arma::arma_binary) and penalty.load(in, arma::arma_binary) and
+    n_active_weights.load(in, arma::arma_binary) and seconds.load(in, arma::arma_binary) and
+    evaluations.load(in, arma::arma_binary) and status.load(in, arma::arma_binary);
+  // the key covers the sizes: a mismatch means a corrupted file
+  if (not read or file_done.n_elem != done.n_elem or
+      vars.n_rows != results.all_variables.n_rows or
+      lambda.n_rows != results.all_lambda.n_rows)
+    return false;
+  for (arma::uword m = 0; m < done.n_elem; m++){
+    if (not file_done(m))
+      continue;
+    done(m) = 1;
+    results.all_variables.col(m) = vars.col(m);
+    results.all_zl.col(m) = zl.col(m);
+    results.all_zu.col(m) = zu.col(m);
+    results.all_lambda.col(m) = lambda.col(m);
+    results.has_multipliers(m) = has_multipliers(m);
+    results.obj_func_vals(m) = obj(m);
+    results.cost_func_vals(m) = cost(m);
+    results.penalty_func_vals(m) = penalty(m);
+    results.n_active_weights(m) = n_active_weights(m);
+    results.solve_seconds(m) = seconds(m);
+    results.evaluations.row(m) = evaluations.row(m);
+    results.status(m) = status(m);
+  }
+  return true;
+}
+
+void Checkpoint::save_restarts(const std::uint64_t key, const FdPotResults& results,
+                               const arma::uvec& done, const arma::uvec& seeds,
+                               const bool force){
+  const std::chrono::duration<double> since = std::chrono::steady_clock::now() - this->last_save;
+  if (not force and since.count() < this->interval_seconds)
+    return;
+  write_atomically(this->path, key, [&](std::ostream& out){
+    return done.save(out, arma::arma_binary) and seeds.save(out, arma::arma_binary) and
+      results.all_variables.save(out, arma::arma_binary) and
+      results.all_zl.save(out, arma::arma_binary) and
+      results.all_zu.save(out, arma::arma_binary) and
+      results.all_lambda.save(out, arma::arma_binary) and
+      results.has_multipliers.save(out, arma::arma_binary) and
+      results.obj_func_vals.save(out, arma::arma_binary) and
+      results.cost_func_vals.save(out, arma::arma_binary) and
+      results.penalty_func_vals.save(out, arma::arma_binary) and
+      results.n_active_weights.save(out, arma::arma_binary) and
+      results.solve_seconds.save(out, arma::arma_binary) and
+      results.evaluations.save(out, arma::arma_binary) and
+      results.status.save(out, arma::arma_binary);
+  });
+  this->last_save = std::chrono::steady_clock::now();
+}
+
+} // namespace fdpot
@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "RcppArmadillo.h"
+#include "FdPotSupport.h"
+
+namespace fdpot{
+
+/*! @brief Checkpoints of a multistart fit, to resume it after an interruption
+
+ @description Two binary files are written next to each other:
+ - path + ".data": the features (not scaled) and the dissimilarity matrix,
+ written once, after they are computed;
+ - path: the restarts solved so far (variables, multipliers, objective
+ terms, timings and telemetry), their seeds and which of them are done,
+ rewritten while the restarts are solved.
+ Each file starts with a key of the problem it belongs to (see key_of): a
+ file of a different problem is ignored, and then overwritten. The files
+ are written to a temporary file first and renamed, so that an interruption
+ while writing leaves the previous checkpoint valid.
+ */
+class Checkpoint{
+public:
+  /*! @brief Constructor
+   @param path_ the file of the restarts; the data go to path_ + ".data"
+   @param interval_seconds_ minimum time between two checkpoints of the
+   restarts (0: after every batch of restarts)
+   */
+  Checkpoint(const std::string& path_, const double interval_seconds_ = 0.):
+    path(path_), interval_seconds(interval_seconds_),
+    last_save(std::chrono::steady_clock::now()) {};
+
+  /*! @brief Hashes a matrix (or vector) together with some parameters
+   @param data the matrix
+   @param params the parameters, e.g. n_feats
+   @param hash the key to continue from, to chain several keys
+   */
+  static std::uint64_t key_of(const arma::mat& data, const arma::vec& params,
+                              const std::uint64_t hash = 14695981039346656037ull);
+
+  /*! @brief Reads the features and the dissimilarities, if saved for this key
+   @return whether they were read
+   */
+  bool load_data(const std::uint64_t key, arma::mat& raw_features, arma::mat& dissim) const;
+
+  /*! @brief Writes the features (not scaled) and the dissimilarities */
+  void save_data(const std::uint64_t key, const arma::mat& raw_features,
+                 const arma::mat& dissim) const;
+
+  /*! @brief Reads the restarts, if saved for this key
+   @param results sized for the problem; the done restarts are overwritten
+   @param done set to 1 for the restarts already solved
+   @return whether they were read
+   */
+  bool load_restarts(const std::uint64_t key, FdPotResults& results, arma::uvec& done) const;
+
+  /*! @brief Writes the restarts, if interval_seconds passed since the last time
+   @param seeds the seeds of the starting points
+   @param force write anyway (e.g. at the end of the fit, or on interrupt)
+   */
+  void save_restarts(const std::uint64_t key, const FdPotResults& results,
+                     const arma::uvec& done, const arma::uvec& seeds,
+                     const bool force = false);
+
+  const std::string path;
+
+private:
+  const double interval_seconds;
+  std::chrono::steady_clock::time_point last_save;
+};
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,157 @@
+#include "CrossValidation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ParallelAD.h"
+#include "Trace.h"
+
+using Rcpp::_;
+
+namespace fdpot{
+
+arma::uvec CrossValidation::stratified_folds(const arma::vec& y, const unsigned n_folds,
+                                             const std::uint32_t seed){
+  std::mt19937 engine{seed};
+  arma::uvec folds(y.n_elem);
+  // the samples of each label are shuffled and dealt to the folds in turn,
+  // starting where the previous label stopped
+  unsigned next = 0;
+  const arma::vec labels = arma::unique(y);
+  for (auto label: labels){
+    std::vector<arma::uword> idx = arma::conv_to<std::vector<arma::uword>>::from(
+      arma::find(y == label));
+    std::shuffle(idx.begin(), idx.end(), engine);
+    for (auto i: idx){
+      folds(i) = next;
+      next = (next + 1) % n_folds;
+    }
+  }
+  return folds;
+}
+
+Rcpp::List CrossValidation::run(const arma::vec& y, const arma::mat& X_coeff,
+                                const arma::uvec& folds, const unsigned n_sols){
+  if (folds.n_elem != y.n_elem)
+    Rcpp::stop("folds must have one element per sample");
+  const unsigned n_folds = folds.max() + 1;
+
+  // shared by all the folds
+  auto start = std::chrono::steady_clock::now();
+  const arma::mat features = this->fd_handler.compute_features(X_coeff, this->n_feats);
+  std::chrono::duration<double> features_seconds = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  const arma::mat dissim = this->fd_handler.compute_dissim_matrix(X_coeff);
+  std::chrono::duration<double> dissim_seconds = std::chrono::steady_clock::now() - start;
+
+  std::vector<arma::uvec> train(n_folds), test(n_folds);
+  for (unsigned f = 0; f < n_folds; f++){
+    train[f] = arma::find(folds != f);
+    test[f] = arma::find(folds == f);
+    if (train[f].is_empty() or test[f].is_empty())
+      Rcpp::stop("fold " + std::to_string(f) + " has no training or no test samples");
+  }
+
+  // the folds are fitted in waves of n_threads: only the dissimilarities of
+  // the folds of a wave are in memory
+  const unsigned n_threads = std::min(this->n_threads, n_folds);
+  const bool from_r = n_threads == 1;
+  arma::vec setup_seconds(n_folds), fit_seconds(n_folds, arma::fill::zeros),
+    predict_seconds(n_folds, arma::fill::zeros);
+  arma::vec accuracy(n_folds);
+  accuracy.fill(arma::datum::nan);
+  Rcpp::List fold_results(n_folds);
+  for (unsigned wave = 0; wave < n_folds; wave += n_threads){
+    const unsigned wave_end = std::min(wave + n_threads, n_folds);
+    // the set up creates CppAD atomic functions: one fold after the other
+    std::vector<arma::vec> y_train(wave_end - wave);  // referenced by the trees
+    std::vector<std::unique_ptr<FdPot>> trees(wave_end - wave);
+    for (unsigned f = wave; f < wave_end; f++){
+      start = std::chrono::steady_clock::now();
+      y_train[f - wave] = y.elem(train[f]);
+      trees[f - wave] = this->make_tree(train[f].n_elem);
+      trees[f - wave]->setup_precomputed(y_train[f - wave],
+                                         arma::mat(features.rows(train[f])),
+                                         std::make_shared<const arma::mat>(
+                                           dissim.submat(train[f], train[f])), n_sols);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      setup_seconds(f) = elapsed.count();
+    }
+
+    // one fold per thread: no R API and CppAD in parallel mode
+    std::vector<FdPotResults> fits(wave_end - wave);
+    std::vector<std::string> errors(wave_end - wave);
+    parallel_ad_setup(n_threads);
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic) if(n_threads > 1)
+    for (unsigned f = wave; f < wave_end; f++){
+      try{
+        auto fold_start = std::chrono::steady_clock::now();
+        fits[f - wave] = trees[f - wave]->optimise(nullptr, from_r);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - fold_start;
+        fit_seconds(f) = elapsed.count();
+      }
+      catch (const std::exception& e){  // nothing may leave the parallel region
+        errors[f - wave] = e.what();
+      }
+      // the memory of the tape goes back to the thread that allocated it
+      trees[f - wave]->release_tape();
+    }
+    parallel_ad_teardown(n_threads);
+    Trace::flush();  // the events of the threads
+
+    for (unsigned f = wave; f < wave_end; f++){
+      if (not errors[f - wave].empty()){
+        Rcpp::Rcout << "fold " << f << ": " << errors[f - wave] << std::endl;
+        fold_results[f] = Rcpp::List::create(_("fold") = f, _("error") = errors[f - wave]);
+        continue;
+      }
+      const auto& fit = fits[f - wave];
+      arma::uvec predicted(test[f].n_elem, arma::fill::zeros);
+      if (std::isfinite(fit.obj_func_vals(fit.best_idx))){
+        start = std::chrono::steady_clock::now();
+        const arma::mat probs = trees[f - wave]->predict_probs(
+          arma::mat(features.rows(test[f])), fit.all_variables.col(fit.best_idx));
+        predicted = arma::index_max(probs, 1);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        predict_seconds(f) = elapsed.count();
+        accuracy(f) = arma::mean(arma::conv_to<arma::vec>::from(
+          arma::conv_to<arma::vec>::from(predicted) == y.elem(test[f])));
+      }
+      fold_results[f] = Rcpp::List::create(
+        _("fold") = f,
+        _("n_train") = train[f].n_elem,
+        _("n_test") = test[f].n_elem,
+        _("accuracy") = accuracy(f),
+        _("setup_seconds") = setup_seconds(f),
+        _("fit_seconds") = fit_seconds(f),
+        _("predict_seconds") = predict_seconds(f),
+        _("test_idx") = test[f],
+        _("predicted_labels") = predicted,
+        _("fit_results") = trees[f - wave]->results_list(fit)
+      );
+    }
+  }  // the trees of the wave, and their dissimilarities, are freed here
+
+  const arma::vec valid = accuracy.elem(arma::find_finite(accuracy));
+  return Rcpp::List::create(
+    _("n_folds") = n_folds,
+    _("folds") = folds,
+    _("accuracy") = accuracy,
+    _("mean_accuracy") = valid.is_empty() ? arma::datum::nan : arma::mean(valid),
+    _("features_seconds") = features_seconds.count(),
+    _("dissim_seconds") = dissim_seconds.count(),
+    _("setup_seconds") = setup_seconds,
+    _("fit_seconds") = fit_seconds,
+    _("predict_seconds") = predict_seconds,
+    _("n_threads") = n_threads,
+    _("fold_results") = fold_results
+  );
+}
+
+} // namespace fdpot
@@ -0,0 +1,73 @@
+#ifndef CROSS_VALIDATION_HH
+#define CROSS_VALIDATION_HH
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "RcppArmadillo.h"
+#include "BasisObj.h"
+#include "FdPot.h"
+
+namespace fdpot{
+
+/*! @brief k-fold cross-validation of the FD-POT
+
+ @description The features and the dissimilarity matrix are the expensive
+ part of the set up of a fit, and they do not depend on the split in folds:
+ they are computed once for the whole dataset, and each fold takes the rows
+ (and the rows and columns) of its training samples by index.
+ The folds are fitted in waves of n_threads, as the trees of a Forest:
+ the trees of a wave are set up one after the other (see
+ FdPot::setup_precomputed) and solved concurrently, one fold per OpenMP
+ thread, then the test samples are predicted with the best solution of
+ each fold and the wave is freed. Hence at most n_threads training
+ submatrices of the dissimilarities are in memory.
+ */
+class CrossValidation{
+public:
+  /*! @brief Creates the (not fitted) tree of a fold given its number of samples */
+  using TreeFactory = std::function<std::unique_ptr<FdPot>(const unsigned n_samples)>;
+
+  /*! @brief Constructor
+   @param fd_handler_ computes features and dissimilarities
+   @param n_feats_ the number of features
+   @param make_tree_ creates the tree of each fold
+   @param n_threads_ how many folds are solved concurrently; with more than
+   one, the restarts of each fold are solved one after the other
+   */
+  CrossValidation(FdHandler<BasisEnum::BSPLINE>&& fd_handler_, const unsigned n_feats_,
+                  TreeFactory make_tree_, const unsigned n_threads_ = 1):
+    fd_handler(std::move(fd_handler_)), n_feats(n_feats_),
+    make_tree(std::move(make_tree_)), n_threads(std::max(n_threads_, 1u)) {};
+
+  /*! @brief Assigns the samples to folds, stratified by label
+   @param y the labels
+   @param n_folds the number of folds
+   @param seed the seed of the shuffling
+   @return the fold of each sample, from 0 to n_folds - 1
+   */
+  static arma::uvec stratified_folds(const arma::vec& y, const unsigned n_folds,
+                                     const std::uint32_t seed);
+
+  /*! @brief Runs the cross-validation
+   @param y the labels
+   @param X_coeff the coefficients matrix of the smoothing
+   @param folds the fold of each sample, from 0 (e.g. from stratified_folds)
+   @param n_sols the number of restarts of each fold
+   @return the accuracy and the timings of each fold, together with its
+   test samples, their predicted labels and the fit results (as returned by
+   FdPot::fit, the chosen solution is best_variables)
+   */
+  Rcpp::List run(const arma::vec& y, const arma::mat& X_coeff,
+                 const arma::uvec& folds, const unsigned n_sols);
+
+private:
+  FdHandler<BasisEnum::BSPLINE> fd_handler;
+  const unsigned n_feats;
+  TreeFactory make_tree;
+  const unsigned n_threads;
+};
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,117 @@
+#include "FdCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace fdpot{
+
+namespace {
+const char suffix[] = ".fdcache";
+} // anonymous namespace
+
+FdCache::FdCache(const std::string& dir_, const double max_bytes_):
+  dir(dir_), max_bytes(max_bytes_){
+  std::error_code error;
+  fs::create_directories(this->dir, error);
+  if (not fs::is_directory(this->dir, error))
+    Rcpp::stop("cannot create the cache directory " + this->dir);
+}
+
+std::shared_ptr<FdCache>& FdCache::global(void){
+  static std::shared_ptr<FdCache> cache = nullptr;
+  return cache;
+}
+
+std::string FdCache::file_of(const std::uint64_t key) const{
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+  return (fs::path(this->dir) / (std::string(name) + suffix)).string();
+}
+
+bool FdCache::load(const std::uint64_t key, arma::mat& value){
+  const std::string file = this->file_of(key);
+  std::ifstream in(file, std::ios::binary);
+  arma::mat read;
+  if (not in or not read.load(in, arma::arma_binary)){
+    this->misses++;
+    return false;
+  }
+  value = std::move(read);
+  std::error_code error;  // recently used: evicted last
+  fs::last_write_time(file, fs::file_time_type::clock::now(), error);
+  this->hits++;
+  return true;
+}
+
+void FdCache::store(const std::uint64_t key, const arma::mat& value){
+  const std::string file = this->file_of(key), tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (not out or not value.save(out, arma::arma_binary) or not out.flush()){
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  // a reader sees the whole entry or none
+  if (std::rename(tmp.c_str(), file.c_str()) != 0){
+    std::remove(tmp.c_str());
+    return;
+  }
+  this->evict();
+}
+
+void FdCache::evict(void) const{
+  struct Entry{
+    fs::path path;
+    fs::file_time_type used;
+    double bytes;
+  };
+  std::vector<Entry> entries;
+  double total = 0.;
+  std::error_code error;
+  for (const auto& item: fs::directory_iterator(this->dir, error)){
+    if (item.path().extension() != suffix)
+      continue;
+    Entry entry{item.path(), item.last_write_time(error),
+                static_cast<double>(item.file_size(error))};
+    if (error)
+      continue;
+    total += entry.bytes;
+    entries.push_back(std::move(entry));
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){
+    return a.used < b.used;
+  });
+  for (const auto& entry: entries){
+    if (total <= this->max_bytes)
+      break;
+    if (fs::remove(entry.path, error))
+      total -= entry.bytes;
+  }
+}
+
+Rcpp::List FdCache::info(void) const{
+  double bytes = 0.;
+  unsigned entries = 0;
+  std::error_code error;
+  for (const auto& item: fs::directory_iterator(this->dir, error))
+    if (item.path().extension() == suffix){
+      bytes += static_cast<double>(item.file_size(error));
+      entries++;
+    }
+  return Rcpp::List::create(
+    Rcpp::_("dir") = this->dir,
+    Rcpp::_("max_bytes") = this->max_bytes,
+    Rcpp::_("entries") = entries,
+    Rcpp::_("bytes") = bytes,
+    Rcpp::_("hits") = static_cast<double>(this->hits),
+    Rcpp::_("misses") = static_cast<double>(this->misses)
+  );
+}
+
+} // namespace fdpot
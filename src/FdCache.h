@@ -0,0 +1,61 @@
+#ifndef FD_CACHE_HH
+#define FD_CACHE_HH
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief Content-addressed cache of features and dissimilarity matrices on disk
+
+ @description FdHandler looks its results up here before computing them:
+ the key is a hash of everything they depend on (the coefficients, the
+ knots and the degree of the basis, the quadrature, the similarity method
+ and the number of features, see FdHandler::cache_key), so that a result
+ is valid as long as its key matches, whatever fit asks for it. Each entry
+ is a file of the directory, named after its key, holding the matrix in
+ Armadillo's binary format.
+ When the entries exceed max_bytes, the least recently used ones (by
+ modification time, which a hit updates) are deleted. A file that cannot
+ be read is a miss; a failed write only skips the caching.
+ The cache of the session is set from R (see global) and used from R's
+ thread only.
+ */
+class FdCache{
+public:
+  /*! @brief Constructor
+   @param dir_ the directory of the entries, created if needed
+   @param max_bytes_ the maximum size of the entries
+   */
+  FdCache(const std::string& dir_, const double max_bytes_);
+
+  /*! @brief the cache of the session, null if caching is off */
+  static std::shared_ptr<FdCache>& global(void);
+
+  /*! @brief Reads an entry
+   @return whether it was found
+   */
+  bool load(const std::uint64_t key, arma::mat& value);
+
+  /*! @brief Writes an entry, then evicts the least recently used ones if
+   the cache is too large
+   */
+  void store(const std::uint64_t key, const arma::mat& value);
+
+  /*! @brief The directory, the size and the hits and misses of this session */
+  Rcpp::List info(void) const;
+
+  const std::string dir;
+  const double max_bytes;
+
+private:
+  unsigned long hits = 0, misses = 0;
+  std::string file_of(const std::uint64_t key) const;
+  void evict(void) const;
+};
+
+} // namespace fdpot
+
+#endif
@@ -1,7 +1,17 @@
 #include "FdPot.h"
+#include "Checkpoint.h"
+#include "GreedyInit.h"
+#include "MemoryViews.h"
+#include "ParallelAD.h"
+#include "ProcessPool.h"
+#include "Trace.h"
 #include <assert.h>     /* assert */
 #include <algorithm> // std::min_element
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <exception>
+#include <numeric>
 
 #include <Rcpp.h>
 #include <omp.h>
@@ -12,22 +22,159 @@
 using namespace fdpot;
 using Rcpp::_;  // named placeholder, used to create an Rcpp List
 
+namespace {
+void check_interrupt(void*){
+  R_CheckUserInterrupt();
+}
+
+/*! @brief Whether the user asked to stop
+Unlike Rcpp::checkUserInterrupt it does not throw (nor jump), hence R's
+thread can call it inside a parallel region.
+*/
+bool user_interrupted(void){
+  return R_ToplevelExec(check_interrupt, nullptr) == FALSE;
+}
+} // anonymous namespace
+
 template<>
 ADdouble ORCT::cdf<ADdouble>(const ADdouble x) const{
    return 1 / (1 + CppAD::exp(- x * this->gamma));
 };
 
+
 Rcpp::List FdPot::fit(const arma::vec& y, const arma::mat & X_coeff,
                       const unsigned n_sols_){
   this->n_sols = n_sols_;
-  // provide the tree class with the number of samples
-#ifndef MYNDEBUG
-  std::cout << "Received dataset with " << this->n_samples << "samples and " << 
-    orct_ptr->n_labels << " different labels" << std::endl;
-#else
-  Rcpp::Rcout << "Received dataset with " << this->n_samples << " and " << 
-    orct_ptr->n_labels << " different labels" << std::endl;
-#endif 
+  this->setup_fit(y, X_coeff);
+  
+  auto res = this->solve_trees();
+  
+  return res;
+}
+
+Rcpp::List FdPot::fit_path(const arma::vec& y, const arma::mat & X_coeff,
+                           const arma::vec& alphas, const unsigned n_sols_){
+  this->n_sols = n_sols_;
+  // the first alpha is used to set up, every other one only changes the
+  // dynamic parameter of the tape (or the objective of the other backends)
+  this->alpha = alphas(0);
+  this->setup_fit(y, X_coeff);
+  
+  Rcpp::List path(alphas.n_elem);
+  FdPotResults previous;  // empty: the first alpha starts from random points
+  for (unsigned a = 0; a < alphas.n_elem; a++){
+    this->set_alpha(alphas(a));
+    Trace::event(Trace::Level::INFO, "fit_path.alpha", "alpha", this->alpha);
+    path[a] = this->solve_trees(&previous);
+  }
+  return path;
+}
+
+Rcpp::List FdPot::refit(const arma::vec& y, const arma::mat & X_coeff,
+                        const unsigned n_new, const arma::mat& start_vars,
+                        const unsigned n_sols_){
+  if (n_new > X_coeff.n_cols)
+    Rcpp::stop("more new samples than samples");
+  if (start_vars.n_rows != orct_ptr->n_vars)
+    Rcpp::stop("the previous solutions do not match the tree (a new label needs a new fit)");
+  this->n_sols = n_sols_;
+  this->n_constrs = std::make_pair(orct_ptr->n_leaf_nodes, orct_ptr->n_labels);
+  this->stage_seconds.zeros();
+  
+  // the data of the previous samples, checkpointed by the previous fit
+  const unsigned n_old = X_coeff.n_cols - n_new;
+  arma::mat raw_features, dissim;
+  const bool extend = n_old > 0 and this->checkpoint != nullptr and 
+    this->checkpoint->load_data(this->data_key(cols_view(X_coeff, 0, n_old)),
+                                raw_features, dissim);
+  if (not extend){
+    Rcpp::Rcout << "No data of the previous samples" << 
+      (this->checkpoint != nullptr ? " in " + this->checkpoint->path + ".data" : "") <<
+      ": computing them" << std::endl;
+    raw_features.reset();
+    dissim.reset();
+  }
+  const unsigned n_known = extend ? n_old : 0u;
+  auto start = std::chrono::steady_clock::now();
+  if (n_known < X_coeff.n_cols)  // the features of a sample depend on it only
+    raw_features = arma::join_cols(raw_features, evalFd.compute_features(
+        cols_view(X_coeff, n_known, X_coeff.n_cols - n_known), orct_ptr->n_feats));
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  this->stage_seconds(0) = elapsed.count();
+  start = std::chrono::steady_clock::now();
+  this->evalFd.extend_dissim_matrix(dissim, X_coeff);
+  elapsed = std::chrono::steady_clock::now() - start;
+  this->stage_seconds(1) = elapsed.count();
+  
+  if (this->checkpoint != nullptr){
+    const std::uint64_t data_key = this->data_key(X_coeff);
+    this->checkpoint->save_data(data_key, raw_features, dissim);
+    // not the key of a fit of the same data: the restarts start elsewhere
+    this->problem_key = Checkpoint::key_of(y, {1.}, data_key);
+  }
+  this->features = std::move(raw_features);
+  this->scale_features(this->features);
+  this->dissim_matrix = std::make_shared<const arma::mat>(std::move(dissim));
+  this->setup_problem(y);
+  
+  // the previous solutions are the starting points, without multipliers:
+  // the samples, hence the active constraints, changed
+  FdPotResults previous(this->n_sols, orct_ptr->n_vars, 0);
+  previous.obj_func_vals.fill(arma::datum::nan);
+  for (unsigned m = 0; m < std::min<unsigned>(this->n_sols, start_vars.n_cols); m++)
+    if (start_vars.col(m).is_finite()){
+      previous.all_variables.col(m) = start_vars.col(m);
+      previous.obj_func_vals(m) = 0.;
+    }
+  return this->solve_trees(&previous);
+}
+
+void FdPot::set_alpha(const double alpha_){
+  this->alpha = alpha_;
+  this->alpha_ad = alpha_;
+  if (this->objective != nullptr)
+    this->objective->set_alpha(alpha_);
+  if (this->optimiser->tape != nullptr)
+    this->optimiser->tape->set_dynamic({alpha_});
+}
+
+Rcpp::List FdPot::derivatives(const arma::vec& y, const arma::mat& X_coeff,
+                              const unsigned n_points){
+  this->setup_fit(y, X_coeff);
+  const unsigned n_vars = orct_ptr->n_vars;
+  arma::mat points(n_vars, n_points), gradients(n_vars, n_points);
+  arma::vec values(n_points);
+  Dvector x(n_vars);
+  for (unsigned p = 0; p < n_points; p++){
+    this->initialise_vars(this->seed + p, x);
+    points.col(p) = x;
+    if (this->objective != nullptr){
+      values(p) = this->objective->gradient(x.memptr(), gradients.colptr(p));
+      continue;
+    }
+    // as TapedNLP evaluates them
+    if (this->optimiser->tape == nullptr){
+      this->alpha_ad = this->alpha;
+      this->optimiser->variables = x;
+      this->optimiser->record_tape({&this->alpha_ad});
+    }
+    CppAD::ADFun<double>& fun = this->optimiser->tape->fun;
+    values(p) = fun.Forward(0, std::vector<double>(x.begin(), x.end()))[0];
+    std::vector<double> w(this->optimiser->n_constraints + 1, 0.);
+    w[0] = 1.;
+    const std::vector<double> grad = fun.Reverse(1, w);
+    std::copy(grad.begin(), grad.begin() + n_vars, gradients.colptr(p));
+  }
+  return Rcpp::List::create(
+    _("points") = points,
+    _("values") = values,
+    _("gradients") = gradients
+  );
+}
+
+void FdPot::setup_fit(const arma::vec& y, const arma::mat & X_coeff){
+  Trace::Span span(Trace::Level::INFO, "setup_fit", "n_samples", this->n_samples,
+                   "n_labels", orct_ptr->n_labels);
   // what we are implicitly doing:
   // cast the coefficients Rcpp::NumericMatrix to an arma::mat (for vec multiplication)
   // avoid copies! https://stackoverflow.com/questions/57516726/converting-r-matrix-to-armamat-with-list
@@ -38,126 +185,221 @@ Rcpp::List FdPot::fit(const arma::vec& y, const arma::mat & X_coeff,
   this->n_constrs.first = orct_ptr->n_leaf_nodes;
   // at least one terminal node per class constraints
   this->n_constrs.second  = orct_ptr->n_labels;
-#ifndef MYNDEBUG
-  std::cout << "Number of single class per leaf constraints " << n_constrs.first << std::endl;
-  std::cout << "Number of termianl node per class " << n_constrs.second << std::endl;
-    std::cout << "Computing features" << std::endl;
-#endif
-#ifdef DEV 
-  Rcpp::Rcout << "Computing features" << std::endl;
-#endif
-  // copy elision
-  this->features = arma::mat(evalFd.compute_features(X_coeff, orct_ptr->n_feats));
-  // this->features = X_coeff.t();
+  // a checkpoint of the same data skips features and dissimilarities
+  std::uint64_t data_key = 0;
+  bool resumed = false;
+  arma::mat dissim;
+  if (this->checkpoint != nullptr){
+    data_key = this->data_key(X_coeff);
+    this->problem_key = Checkpoint::key_of(y, {}, data_key);
+    resumed = this->checkpoint->load_data(data_key, this->features, dissim);
+    if (resumed)
+      Rcpp::Rcout << "Features and dissimilarities read from " << 
+        this->checkpoint->path << ".data" << std::endl;
+  }
+  this->stage_seconds.zeros();
+  if (not resumed){
+    auto start = std::chrono::steady_clock::now();
+    // copy elision
+    this->features = arma::mat(evalFd.compute_features(X_coeff, orct_ptr->n_feats));
+    // this->features = X_coeff.t();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    this->stage_seconds(0) = elapsed.count();
+    start = std::chrono::steady_clock::now();
+    dissim = this->evalFd.compute_dissim_matrix(X_coeff);
+    elapsed = std::chrono::steady_clock::now() - start;
+    this->stage_seconds(1) = elapsed.count();
+    if (this->checkpoint != nullptr)  // saved before scaling, as setup_precomputed wants them
+      this->checkpoint->save_data(data_key, this->features, dissim);
+  }
+  this->dissim_matrix = std::make_shared<const arma::mat>(std::move(dissim));
   // scale features
   this->scale_features(this->features);
-#ifndef MYNDEBUG 
-  std::cout << "Printing standardised features" << std::endl;
-  for (unsigned p = 0; p < this->features.n_cols; p++)
-    std::cout << this->features.col(p) << std::endl;
-  std::cout << "Computing dissimilarity matrix" << std::endl;
-#endif
-#ifdef DEV 
-  Rcpp::Rcout << "Computing dissimilarity matrix" << std::endl;
-#endif
-  this->dissim_matrix = this->evalFd.compute_dissim_matrix(X_coeff);
-  
-#ifndef MYNDEBUG 
-  std::cout << "Setting up optimiser" << std::endl;
-#endif
-#ifdef DEV 
-  Rcpp::Rcout << "Setting up optimiser" << std::endl;
-#endif
-  
-  this->setup_optimiser(y, X_coeff);
-    
-#ifndef MYNDEBUG 
-  std::cout << "Solving problems with different init points" << std::endl;
-#endif
-#ifdef DEV 
-  Rcpp::Rcout << "Solving problems with different init points" << std::endl;
-#endif
-  
-  auto res = this->solve_trees();
+  this->setup_problem(y);
+}
+
+void FdPot::set_checkpoint(const std::string& path, const double interval_seconds){
+  if (path.empty())
+    this->checkpoint = nullptr;
+  else
+    this->checkpoint = std::make_unique<Checkpoint>(path, interval_seconds);
+}
+
+void FdPot::set_processes(const unsigned n_processes_){
+  if (n_processes_ > 0 and not ProcessPool::available()){
+    Rcpp::warning("worker processes need fork(): the restarts are solved in this process");
+    this->n_processes = 0;
+    return;
+  }
+  this->n_processes = n_processes_;
+}
+
+std::uint64_t FdPot::data_key(const arma::mat& X_coeff){
+  // the basis and the quadrature as well: the features and the
+  // dissimilarities depend on them
+  return this->evalFd.cache_key(X_coeff, "checkpoint.data", orct_ptr->n_feats);
+}
+
+std::uint64_t FdPot::fit_key(void) const{
+  // everything that changes the solutions of the restarts
+  const SolverConfig config = this->solver_config.effective(this->backend);
+  const RacingConfig& racing = config.racing;
+  const StochasticConfig& stochastic = config.stochastic;
+  const arma::vec params{this->alpha, static_cast<double>(this->seed),
+    static_cast<double>(this->n_sols), static_cast<double>(orct_ptr->depth),
+    static_cast<double>(orct_ptr->n_labels), orct_ptr->gamma, this->l1_lambda,
+    this->sparsity_tol, static_cast<double>(this->backend), config.tol,
+    config.acceptable_tol, static_cast<double>(config.max_iter),
+    static_cast<double>(racing.enabled), static_cast<double>(racing.initial_iter),
+    racing.keep_fraction, racing.growth, static_cast<double>(racing.min_survivors),
+    racing.feasibility_tol,
+    static_cast<double>(config.init == "cart") + 2. * (config.init == "mixed"),
+    static_cast<double>(config.hessian_approximation == "exact"),
+    stochastic.learning_rate, static_cast<double>(stochastic.batch_size),
+    static_cast<double>(stochastic.pair_batch_size),
+    static_cast<double>(stochastic.max_epochs), stochastic.holdout_fraction,
+    static_cast<double>(stochastic.patience), stochastic.rel_tol,
+    stochastic.coverage_weight};
+  // the options given by name
+  const std::string names = config.linear_solver + "\n" + stochastic.method;
+  return Checkpoint::key_of(arma::mat(), params,
+                            helpers::fnv1a(names.data(), names.size(), this->problem_key));
+}
+
+void FdPot::setup_precomputed(const arma::vec& y, arma::mat&& raw_features,
+                              std::shared_ptr<const arma::mat> dissim,
+                              const unsigned n_sols_){
+  if (dissim == nullptr or dissim->n_rows != y.n_elem or dissim->n_cols != y.n_elem)
+    Rcpp::stop("the dissimilarity matrix must be n_samples x n_samples");
+  this->n_sols = n_sols_;
+  this->n_constrs = std::make_pair(orct_ptr->n_leaf_nodes, orct_ptr->n_labels);
+  this->stage_seconds.zeros();  // computed by the caller
+  this->features = std::move(raw_features);
+  this->scale_features(this->features);
+  this->dissim_matrix = std::move(dissim);
+  this->setup_problem(y);
+}
+
+void FdPot::setup_problem(const arma::vec& y){
+  auto start = std::chrono::steady_clock::now();
+  this->labels = &y;
+  this->features_t = this->features.t();  // once scaled
+  this->leaf_quad_form = std::make_unique<QuadFormAtomic>("leaf_quad_form",
+                                                          this->dissim_matrix);
   
-  return res;
+  this->setup_optimiser(y);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  this->stage_seconds(2) = elapsed.count();
+  Trace::event(Trace::Level::INFO, "setup_problem", "seconds", this->stage_seconds(2),
+               "n_vars", orct_ptr->n_vars);
+  Trace::flush();  // from R's thread (see setup_precomputed)
+}
+
+arma::mat FdPot::predict_probs(arma::mat&& raw_features, const arma::vec& vars) const{
+  // scaled on their own, as predict_FdPot_Rcpp does
+  this->scale_features(raw_features);
+  return orct_ptr->predict_probs(raw_features, vars);
 }
 
 
-OptimTraits::OptimFuns FdPot::create_mathematical_model(const arma::vec& y,
-                                                        const arma::mat & X_coeff){
+template<typename VarVecT>
+std::vector<typename VarVecT::value_type> FdPot::leaf_probas(const VarVecT& vars) const{
+  std::vector<typename VarVecT::value_type> P(this->n_samples * orct_ptr->n_leaf_nodes);
+  for (unsigned i = 0; i < this->n_samples; i++)
+    orct_ptr->proba_fall_leaves<VarVecT>(this->features_t.colptr(i), vars, P.data() + i,
+                                         this->n_samples);
+  return P;
+}
+
+OptimTraits::OptimFuns FdPot::create_mathematical_model(const arma::vec& y){
   
   
   // initialise what we retur  (recall std::function is a pointer wrapper)
   OptimTraits::OptimFuns f = nullptr;
   
-  this->cost_func = [this, &y] (const VariantVarsT& vars) -> ADdouble {
-    // I first create the visitor:
-    
-    
-    ADdouble e_cost = 0.;
+  // expected misclassification cost given the leaf probabilities P
+  auto expected_cost = [this, &y] (const auto& P, const auto& vars){
+    using VarT = typename std::decay_t<decltype(vars)>::value_type;
+    VarT e_cost = 0.;
     // note this loop cannot be parallelised since it is the function that Ipopt will use
-    for (unsigned i = 0; i < this->n_samples; i++){ // all samples
-      for (unsigned leaf = orct_ptr->n_int_nodes; // first leaf comes after int_nodes
-              leaf < orct_ptr->n_nodes; leaf++){  // all leafs
-        
-        ADdouble leaf_c = 0.;  // cost of the current leaf
-        
-        // first_class var in this leaf
-        unsigned c_kt = orct_ptr->var_map(leaf);
-        
-        for (unsigned k = 0; k < orct_ptr->n_labels; k ++){
-          // Sadly, I had to redefine the overloaded visitor at each iteration:
-          auto visitor_add_leaf_c = OverloadedVisitor{
-            [this, &leaf_c,
-             &leaf, &y, &i, &k, &c_kt](const arma::vec& vars){
-              leaf_c += orct_ptr->proba_fall_leaf<arma::vec>(
-                features.row(i), vars, leaf) * this->miss_class_cost(y(i), k) * vars[c_kt++];
-              // decided to use the ARMA_NO_DEBUG macro
-            },
-            [this, &leaf_c, &leaf, &y, &i, &k, &c_kt](
-                const OptimTraits::ADvector& vars){
-              leaf_c += orct_ptr->proba_fall_leaf<OptimTraits::ADvector>(
-                this->features.row(i), vars, leaf) *\
-                  this->miss_class_cost(y(i), k) * vars[c_kt++];
-            }
-          };
-          
-          
-          //leaf_c += orct_ptr->proba_fall_leaf(this->features.row(i), vars, leaf) * 
-          //  this->miss_class_cost(y(i), k) * vars[c_kt++];
-          std::visit(visitor_add_leaf_c, vars);
-          
-        }
-        e_cost += leaf_c;
-      }
+    for (unsigned t = 0; t < orct_ptr->n_leaf_nodes; t++){  // all leafs
+      // first_class var in this leaf
+      const unsigned c_kt = orct_ptr->var_map(orct_ptr->n_int_nodes + t);
+      // the sum over the labels of the costs times c_kt only depends on
+      // the label of the sample: cost * (sum_k c_kt - c_yt)
+      VarT sum_c = 0.;
+      for (unsigned k = 0; k < orct_ptr->n_labels; k ++)
+        sum_c += vars[c_kt + k];
       
+      for (unsigned i = 0; i < this->n_samples; i++){ // all samples
+        const unsigned y_i = static_cast<unsigned>(y(i));
+        e_cost += P[t * this->n_samples + i] * this->missclaf_cost * 
+          (sum_c - vars[c_kt + y_i]);
+      }
     }
-
     e_cost /= this->n_samples;
     return e_cost;
   };
   
-  this->penalty_func = [this, &y] (const OptimTraits::ADvector& vars) -> ADdouble{
-    // expected dissimilarity per leaf
-    ADdouble e_diss = 0.;
-    // the idx of the first leaf nodes is the number of interior nodes
-    for (unsigned tau = orct_ptr->n_int_nodes; tau < orct_ptr->n_nodes; tau++){
-      ADdouble leaf_d = 0.;  // leaf dissimilarity
-      for (unsigned i = 0; i < this->n_samples; i++){
-        for (unsigned j = i+1; j < this->n_samples; j++){
-          leaf_d +=  orct_ptr->proba_fall_leaf(this->features.row(i), vars, tau) *
-            orct_ptr->proba_fall_leaf(this->features.row(j), vars, tau) * 
-            this->dissim_matrix(i, j);
-        }
+  // expected dissimilarity per leaf given the leaf probabilities P
+  auto expected_dissim = [this] (const auto& P){
+    using VarT = typename std::decay_t<decltype(P)>::value_type;
+    VarT e_diss = 0.;
+    const unsigned n = this->n_samples;
+    for (unsigned t = 0; t < orct_ptr->n_leaf_nodes; t++){
+      // sum over the pairs i < j of p_i p_j D_ij
+      if constexpr (std::is_same<VarT, ADdouble>::value){
+        // a single operation on the tape
+        OptimTraits::ADvector p(P.cbegin() + t * n, P.cbegin() + (t + 1) * n), leaf_d(1);
+        (*this->leaf_quad_form)(p, leaf_d);
+        e_diss += leaf_d[0];
+      }
+      else{
+        const arma::vec p(P.data() + t * n, n);
+        const arma::mat& dissim = *this->dissim_matrix;
+        e_diss += 0.5 * (arma::dot(p, dissim * p) - 
+          arma::dot(arma::square(p), dissim.diag()));
       }
-      e_diss += leaf_d;
     }
     e_diss /= orct_ptr->n_leaf_nodes;
     return e_diss;
   };
+  
+  // the reported terms: the variables are either AD (while taping) or the solutions
+  this->cost_func = [this, expected_cost] (const VariantVarsT& vars) -> ADdouble {
+    return std::visit([this, &expected_cost](const auto& v) -> ADdouble {
+      return expected_cost(this->leaf_probas(v), v);
+    }, vars);
+  };
+  
+  this->penalty_func = [this, expected_dissim] (const VariantVarsT& vars) -> ADdouble{
+    return std::visit([this, &expected_dissim](const auto& v) -> ADdouble {
+      return expected_dissim(this->leaf_probas(v));
+    }, vars);
+  };
+
+  this->l1_func = [this] (const OptimTraits::ADvector& vars) -> ADdouble{
+    ADdouble l1 = 0.;
+    const double sqrt_eps = std::sqrt(this->l1_eps);
+    for (unsigned node = 0; node < orct_ptr->n_int_nodes; node++){
+      unsigned first_idx = orct_ptr->var_map(node);
+      // the intercept (last variable of the node) is not penalised
+      for (unsigned j = first_idx; j < first_idx + orct_ptr->n_feats; j++)
+        l1 += CppAD::sqrt(vars[j] * vars[j] + this->l1_eps) - sqrt_eps;
+    }
+    return l1;
+  };
 
-  // obj_fn era qui    
+  this->obj_function = [this, expected_cost, expected_dissim] (
+      const OptimTraits::ADvector& vars) -> ADdouble{
+    // one evaluation of the leaf probabilities feeds both terms
+    const OptimTraits::ADvector P = this->leaf_probas(vars);
+    // alpha_ad is a dynamic parameter of the tape (see solve_trees)
+    ADdouble obj = expected_cost(P, vars) + this->alpha_ad * expected_dissim(P);
+    if (this->l1_lambda > 0.)
+      obj += this->l1_lambda * this->l1_func(vars);
+    return obj;
+  };
   
   auto constr_single_class_pred = [this] (const OptimTraits::ADvector& vars,
                                           const unsigned leaf) -> ADdouble{
@@ -197,17 +439,14 @@ OptimTraits::OptimFuns FdPot::create_mathematical_model(const arma::vec& y,
   return f;
   };
 
-void FdPot::setup_optimiser(const arma::vec& y, const arma::mat & X_coeff){
+void FdPot::setup_optimiser(const arma::vec& y){
 
   this->optimiser->create_variables(orct_ptr->n_vars,
                                     orct_ptr->n_leaf_nodes + orct_ptr->n_labels);
   
-#ifndef MYNDEBUG
-  std::cout<< "Created variables: n_feats " << orct_ptr->n_feats << " n int nodes: " <<
-    orct_ptr->n_int_nodes << " n_labels " << orct_ptr->n_labels << " n_leaf nodes " <<
-      orct_ptr->n_leaf_nodes << " yields n_vars " <<orct_ptr-> n_vars << 
-        " and n_constraints " << orct_ptr->n_leaf_nodes + orct_ptr->n_labels << std::endl;
-#endif
+  Trace::event(Trace::Level::DEBUG, "setup_optimiser.variables", "n_vars", orct_ptr->n_vars,
+               "n_constraints", orct_ptr->n_leaf_nodes + orct_ptr->n_labels,
+               "n_int_nodes", orct_ptr->n_int_nodes);
   
   // set up variables' bounds
   Dvector vars_lb(optimiser->n_vars), vars_ub(optimiser->n_vars);
@@ -234,10 +473,18 @@ void FdPot::setup_optimiser(const arma::vec& y, const arma::mat & X_coeff){
     g_lb[c] = 1.;
     g_ub[c] = 1.0e19; // no upper bound
   }
-  this->optimiser->set_math_program(this->create_mathematical_model(y, X_coeff),
+  this->optimiser->set_math_program(this->create_mathematical_model(y),
                                     std::move(vars_lb), std::move(vars_ub),
                                     std::move(g_lb), std::move(g_ub)
                                     );
+  this->optimiser->backend = this->backend;
+  this->optimiser->config = this->solver_config;
+  if (this->backend != OptimBackend::CPPAD){
+    this->objective = std::make_shared<OrctObjective>(
+      *orct_ptr, this->features_t, y, *this->dissim_matrix, this->alpha,
+      this->missclaf_cost, this->l1_lambda, this->l1_eps);
+    this->optimiser->objective = this->objective;
+  }
 }
 
 
@@ -254,50 +501,37 @@ void FdPot::initialise_vars(std::uint32_t seed, Dvector & vars){
     unsigned first_idx = orct_ptr->var_map(leaf);
     // sample
     std::vector<double> sample = dirichlet_distrib(engine);
-#ifndef MYNDEBUG
-  //  std::cout << "Printing dirichlet sample for leaf " << leaf << " of\
-    //sample of length " << sample.size() << std::endl;
-#endif
-#ifdef DEV
-   // Rcpp::Rcout << "Printing dirichlet sample for leaf " << leaf << " of\
-  //  sample of length " << sample.size() << std::endl;
-#endif
     // now fill the leaf variables
     unsigned i = 0;
     for (unsigned k= first_idx; k < first_idx + orct_ptr->n_labels; k++){
             vars.at(k) = sample.at(i++);
-    #ifndef MYNDEBUG
-    //  std::cout << vars.at(k) << "\t";
-    #endif
     }
-    #ifndef MYNDEBUG 
-    //std::cout<< std::endl;
-    #endif
   }
   // uniform for all other parameters
   std::uniform_real_distribution<> uniform_distrib(0, 1);  // set up distrib
   
   for (unsigned node = 0; node < orct_ptr->n_int_nodes; node++){
     unsigned first_idx = orct_ptr->var_map(node);
-    
-  #ifndef MYNDEBUG
-   // std::cout << "Printing variables for node " << node << " whose\
-    //starting index in the vars vector is " << first_idx << std::endl;
-  #endif
     // we have n_feats + 1 variables per interior node
     for (unsigned j = first_idx; j < first_idx + (orct_ptr->n_feats + 1); j++){
       vars.at(j) = uniform_distrib(engine);
-      #ifndef MYNDEBUG
-       // std::cout<< vars.at(j) << "\t";
-      #endif
     }
-    #ifndef MYNDEBUG
-     // std::cout << std::endl;
-    #endif
   }
 }
   
-Rcpp::List FdPot::solve_trees(void){
+Rcpp::List FdPot::solve_trees(FdPotResults* warm_start){
+  FdPotResults results = this->optimise(warm_start);
+  if (warm_start != nullptr)  // the starting points of the next problem
+    *warm_start = results;
+  return this->results_list(results);
+}
+
+FdPotResults FdPot::optimise(FdPotResults* warm_start, const bool from_r){
+  auto optimise_start = std::chrono::steady_clock::now();
+  auto span = std::make_unique<Trace::Span>(Trace::Level::INFO, "optimise", "n_sols",
+                                            this->n_sols, "depth", orct_ptr->depth);
+  // the restarts reuse the memory of the sweeps of the previous ones
+  const ADMemoryHold ad_memory;
   // create the random seeds
   std::vector<unsigned> seeds(this->n_sols);  // setup seeds vector
   for (unsigned i = 0; i < this->n_sols; i++)
@@ -306,78 +540,385 @@ Rcpp::List FdPot::solve_trees(void){
   seq.generate(seeds.begin(), seeds.end());
   
   // prepare results variable
-  FdPotResults results(this->n_sols, orct_ptr->n_vars);
+  FdPotResults results(this->n_sols, orct_ptr->n_vars, optimiser->n_constraints);
 
-  std::vector<OptimHandler> optimhandlers(n_sols);
+  // record the tape once: the restarts only differ for the starting point,
+  // and alpha is a dynamic parameter (see set_alpha)
+  const bool taped = this->backend == OptimBackend::CPPAD;
+  if (taped and this->optimiser->tape == nullptr){
+    this->alpha_ad = this->alpha;
+    this->initialise_vars(this->seed, this->optimiser->variables);
+    this->optimiser->record_tape({&this->alpha_ad});
+    Trace::event(Trace::Level::INFO, "tape.recorded", "seconds",
+                 optimiser->tape->record_seconds);
+  }
+  // restart m continues from the solution m of the previous problem, if any
+  const bool warm = warm_start != nullptr and 
+    warm_start->all_variables.n_cols == this->n_sols;
+  
+  std::vector<OptimHandler>& optimhandlers = this->handlers;
+  optimhandlers.resize(n_sols);
+  // the greedy trees are grown on the scaled features (see SolverConfig::init)
+  const GreedyInit greedy(*orct_ptr, this->features, *this->labels);
   
   #pragma omp parallel for
   for (unsigned m = 0; m < n_sols; m++){
-    optimhandlers[m] = OptimHandler(*(this->optimiser));
-    // initialise variables with current seed
-   this->initialise_vars(seeds.at(m), optimhandlers[m].variables);
+    optimhandlers[m].reset_from(*(this->optimiser));
+    optimhandlers[m].seed = seeds.at(m);
+    if (warm and std::isfinite(warm_start->obj_func_vals(m))){
+      optimhandlers[m].variables = warm_start->all_variables.col(m);
+      if (warm_start->has_multipliers(m)){
+        optimhandlers[m].zl0 = warm_start->all_zl.col(m);
+        optimhandlers[m].zu0 = warm_start->all_zu.col(m);
+        optimhandlers[m].lambda0 = warm_start->all_lambda.col(m);
+      }
+    }
+    else if (this->solver_config.cart_start(m)){
+      // the first greedy tree sees all the samples, the others a bootstrap
+      greedy.initialise(m == 0 ? 0u : seeds.at(m), optimhandlers[m].variables);
+      results.cart_start(m) = 1;
+    }
+    else  // initialise variables with current seed
+      this->initialise_vars(seeds.at(m), optimhandlers[m].variables);
   }
   
+  // worker processes are forked from R's thread only (see set_processes)
+  const unsigned n_processes = from_r ? std::min(this->n_processes, this->n_sols) : 0u;
 #ifdef _OPENMP
-  
-  int threads = omp_get_num_threads();
-  std::cout << "open mp active. n threads " << threads << std::endl;
-  std::cout << "Runinng in parallel: " << std::endl;
+  // away from R's thread (e.g. a fold of CrossValidation) the caller set CppAD up
+  const unsigned n_threads = from_r and n_processes == 0 ? 
+    std::min(this->n_threads, this->n_sols) : 1u;
+  // CppAD needs to know how to identify the threads before the AD operations
+  // run in parallel; each thread then gets its own copy of the tape
+  // (the native backend has no tape and uses no AD type while solving)
+  if (taped)
+    parallel_ad_setup(n_threads);
+  std::vector<std::shared_ptr<ADTape>> thread_tapes(n_threads, this->optimiser->tape);
+  #pragma omp parallel num_threads(n_threads) if(n_threads > 1 and taped)
+  {
+    const unsigned t = omp_get_thread_num();
+    if (t > 0){
+      thread_tapes[t] = this->optimiser->tape->copy();
+      thread_tapes[t]->set_dynamic({this->alpha});
+    }
+  }
+#else
+  const unsigned n_threads = 1;
 #endif
+  Trace::event(Trace::Level::DEBUG, "optimise.workers", "n_threads", n_threads,
+               "n_processes", n_processes, "warm", warm);
+  // failed restarts are never the best ones
+  results.obj_func_vals.fill(arma::datum::inf);
+  std::vector<std::string>& errors = results.errors;
   
-  // #pragma omp parallel for shared(optimhandlers, results)
-  for (unsigned m = 0; m < n_sols; m++){
-    // initialise the current optimisation handler
-    // NB the copy constructor is used since the structure is the same
-    // for std::move another variable would have to be used; the gained efficiency
-    // was not worth the "ugly" code in my opinion
-    auto& cur_optim_hdler =  optimhandlers[m];  
+  // the restarts found in the checkpoint of this problem are not solved again
+  arma::uvec done(n_sols, arma::fill::zeros);
+  const arma::uvec seeds_of = arma::conv_to<arma::uvec>::from(seeds);
+  const std::uint64_t key = this->checkpoint != nullptr ? this->fit_key() : 0;
+  if (this->checkpoint != nullptr and 
+      this->checkpoint->load_restarts(key, results, done) and from_r)
+    Rcpp::Rcout << arma::accu(done) << " of " << n_sols << 
+      " restarts read from " << this->checkpoint->path << std::endl;
+  
+  // stores the solution of restart m in results
+  auto store = [&](const unsigned m){
+    auto& cur_optim_hdler =  optimhandlers[m];
+    const SolveCounts& counts = cur_optim_hdler.counts;
+    results.evaluations.row(m) = arma::Row<int>{counts.iterations, counts.obj_evals,
+      counts.constr_evals, counts.grad_evals, counts.jac_evals, counts.hess_evals};
+    results.status(m) = cur_optim_hdler.solution.status;
+    if (not errors[m].empty())
+      return;  // reported by results_list
     
-
-    // perform the optimisation
-    try{
-      cur_optim_hdler.solve();
-    }
-    catch (const std::runtime_error&e){
-      Rcpp::Rcout << e.what() << std::endl;
-      continue;
-    }
+    if (this->l1_lambda > 0.)  // keep only the surviving weights
+      results.n_active_weights(m) = orct_ptr->prune_weights(
+        cur_optim_hdler.solution.x, this->sparsity_tol);
+    else
+      results.n_active_weights(m) = orct_ptr->n_int_nodes * orct_ptr->n_feats;
     
     results.all_variables.col(m) = std::move(cur_optim_hdler.solution.x);
+    const auto& sol = cur_optim_hdler.solution;
+    if (sol.zl.n_elem == orct_ptr->n_vars and sol.lambda.n_elem == results.all_lambda.n_rows){
+      results.all_zl.col(m) = sol.zl;
+      results.all_zu.col(m) = sol.zu;
+      results.all_lambda.col(m) = sol.lambda;
+      results.has_multipliers(m) = 1;
+    }
 
-    auto vars_ad = OptimTraits::ADvector(results.all_variables.col(m).cbegin(),
-                                         results.all_variables.col(m).cend());
+    double l1 = 0.;  // the smoothed L1 penalty of the split weights
+    if (this->optimiser->objective != nullptr){  // no AD needed
+      arma::mat P;
+      const double* x = results.all_variables.colptr(m);
+      this->optimiser->objective->leaf_probas(x, P);
+      results.cost_func_vals(m) = this->optimiser->objective->cost(P, x);
+      results.penalty_func_vals(m) = this->optimiser->objective->penalty(P);
+      if (this->l1_lambda > 0.)
+        l1 = this->optimiser->objective->l1(x);
+    }
+    else{
+      // evaluated in double precision, no tape is needed
+      const VariantVarsT vars = arma::vec(results.all_variables.col(m));
+      results.cost_func_vals(m) = CppAD::Value(this->cost_func(vars));
+      results.penalty_func_vals(m) = CppAD::Value(this->penalty_func(vars));
+      if (this->l1_lambda > 0.){
+        OptimTraits::ADvector ad_vars(orct_ptr->n_vars);
+        for (unsigned j = 0; j < orct_ptr->n_vars; j++)
+          ad_vars[j] = results.all_variables(j, m);
+        l1 = CppAD::Value(this->l1_func(ad_vars));
+      }
+    }
     
-    //results.cost_func_vals(m) = CppAD::Value(this->cost_func(vars_ad));
-    results.cost_func_vals(m) = CppAD::Value(this->cost_func(results.all_variables.col(m)));
-      //CppAD::Value(*(this->cost_func)(cur_optim_hdler.variables));
-
-    results.penalty_func_vals(m) = \
-      CppAD::Value(this->penalty_func(vars_ad));
+    // the objective of the stored (pruned) variables, which the solutions
+    // are ranked by: Ipopt's value is the one before pruning
+    results.obj_func_vals(m) = results.cost_func_vals(m) + 
+      this->alpha * results.penalty_func_vals(m) + this->l1_lambda * l1;
+    done(m) = 1;
+    Trace::event(Trace::Level::DEBUG, "optimise.restart", "restart", m, "obj",
+                 results.obj_func_vals(m), "status", results.status(m));
+  };
+  
+  // the restarts solved by worker processes: a worker solves its copy of the
+  // handler and sends back what store and RestartRace read from it
+  auto solve_in_processes = [&](const std::vector<unsigned>& todo, const bool final){
+    auto work = [&](const unsigned m, ProcessPool::Message& out){
+      auto& cur_optim_hdler = optimhandlers[m];
+      std::string error;
+      auto start = std::chrono::steady_clock::now();
+      try{
+        cur_optim_hdler.solve();
+      }
+      catch (const std::exception& e){
+        error = e.what();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      const auto& sol = cur_optim_hdler.solution;
+      out.put(static_cast<int>(sol.status));
+      out.put(sol.obj_value);
+      out.put(sol.x);
+      out.put(sol.zl);
+      out.put(sol.zu);
+      out.put(sol.lambda);
+      out.put(cur_optim_hdler.iter_log);
+      out.put(cur_optim_hdler.counts);
+      out.put(elapsed.count());
+      out.put(error);
+    };
+    auto receive = [&](const unsigned m, ProcessPool::Message& in){
+      auto& cur_optim_hdler = optimhandlers[m];
+      auto& sol = cur_optim_hdler.solution;
+      int status = 0;
+      double seconds = 0.;
+      in.get(status);
+      sol.status = static_cast<decltype(sol.status)>(status);
+      in.get(sol.obj_value);
+      in.get(sol.x);
+      in.get(sol.zl);
+      in.get(sol.zu);
+      in.get(sol.lambda);
+      in.get(cur_optim_hdler.iter_log);
+      in.get(cur_optim_hdler.counts);
+      in.get(seconds);
+      in.get(errors[m]);
+      results.solve_seconds(m) += seconds;
+      if (final){
+        store(m);
+        if (this->checkpoint != nullptr)
+          this->checkpoint->save_restarts(key, results, done, seeds_of);
+      }
+    };
+    auto lost = [&](const unsigned m, const std::string& reason){
+      errors[m] = reason;
+      if (final)
+        store(m);
+    };
+    try{
+      ProcessPool(n_processes).run(todo, work, receive, lost);
+    }
+    catch (const Rcpp::internal::InterruptedException&){
+      if (final and this->checkpoint != nullptr)  // resume from here
+        this->checkpoint->save_restarts(key, results, done, seeds_of, true);
+      throw;
+    }
+  };
+  
+  // the restarts are shared dynamically among the threads, so that none
+  // waits for the slowest restart of a batch. The master thread (R's) takes
+  // the restarts the others have solved, stores (and checkpoints) them with
+  // final, and checks whether the user asked to stop: the other threads
+  // then take no new restart
+  auto solve_restarts = [&](const std::vector<unsigned>& todo, const bool final){
+    if (n_processes > 0){
+      solve_in_processes(todo, final);
+      return;
+    }
+    std::vector<double> seconds(n_sols, 0.);
+    std::vector<unsigned> solved;  // not taken by the master thread yet
+    solved.reserve(todo.size());
+    std::atomic<bool> interrupted{false};
+    std::exception_ptr failure = nullptr;  // of a checkpoint, raised after the loop
+    // from the master thread only
+    auto take_solved = [&](void){
+      std::vector<unsigned> taken;
+      #pragma omp critical(fdpot_solved_restarts)
+      taken.swap(solved);
+      for (auto m: taken){
+        results.solve_seconds(m) += seconds[m];
+        if (final)
+          store(m);
+      }
+      if (final and not taken.empty() and this->checkpoint != nullptr)
+        this->checkpoint->save_restarts(key, results, done, seeds_of);
+      if (from_r and not interrupted and user_interrupted())
+        interrupted = true;
+    };
     
-    results.obj_func_vals(m) =  cur_optim_hdler.solution.obj_value;
-    Rcpp::checkUserInterrupt();  // check if the user has clicked stop
-
-}  // end for
-  //#ifndef MYNDEBUG
-      //std::cout << "Solution " << m << " with value " <<
-     //   cur_optim_hdler.solution.obj_value <<std::endl;
-  //#endif
-  unsigned best_idx = std::distance(results.obj_func_vals.cbegin(), 
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic) if(n_threads > 1)
+    for (unsigned k = 0; k < todo.size(); k++){
+      if (interrupted)
+        continue;
+      const unsigned m = todo[k];
+      auto& cur_optim_hdler =  optimhandlers[m];  
+#ifdef _OPENMP
+      cur_optim_hdler.tape = thread_tapes[omp_get_thread_num()];
+      const bool master = omp_get_thread_num() == 0;
+#else
+      const bool master = true;
+#endif
+      // perform the optimisation
+      try{
+        auto start = std::chrono::steady_clock::now();
+        cur_optim_hdler.solve();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        seconds[m] = elapsed.count();
+      }
+      catch (const std::exception&e){  // nothing may leave the parallel region
+        errors[m] = e.what();
+      }
+      #pragma omp critical(fdpot_solved_restarts)
+      solved.push_back(m);
+      if (master and failure == nullptr){
+        try{
+          take_solved();
+        }
+        catch (...){  // nothing may leave the parallel region
+          failure = std::current_exception();
+          interrupted = true;
+        }
+      }
+    }
+    if (failure != nullptr)
+      std::rethrow_exception(failure);
+    take_solved();  // the last ones of the other threads
+    if (interrupted){
+      if (final and this->checkpoint != nullptr)  // resume from here
+        this->checkpoint->save_restarts(key, results, done, seeds_of, true);
+      throw Rcpp::internal::InterruptedException();
+    }
+  };
+  
+  // either every restart is solved to convergence, or they race (successive
+  // halving, see RestartRace) and only the survivors are; a race is
+  // checkpointed once it is over, since its rounds depend on each other
+  const SolverConfig config = this->solver_config.effective(this->backend);
+  if (arma::all(done)){
+    // resumed from a checkpoint of the whole fit
+  }
+  else if (config.racing.enabled){
+    auto race = std::make_shared<RestartRace>(config.racing, n_sols, config.max_iter);
+    for (auto todo = race->next_round(optimhandlers, errors); not todo.empty(); 
+         todo = race->next_round(optimhandlers, errors))
+      solve_restarts(todo, false);
+    results.race = race;
+    // results are stored by restart index: same outcome as the serial loop
+    for (unsigned m = 0; m < n_sols; m++)
+      store(m);
+  }
+  else{
+    std::vector<unsigned> todo;
+    for (unsigned m = 0; m < n_sols; m++)
+      if (not done(m))
+        todo.push_back(m);
+    solve_restarts(todo, true);
+  }
+  if (this->checkpoint != nullptr)
+    this->checkpoint->save_restarts(key, results, done, seeds_of, true);
+  
+  // the pooled handlers do not keep the tapes (the next problem may record
+  // another one)
+  for (auto& hdler: optimhandlers)
+    hdler.tape = nullptr;
+#ifdef _OPENMP
+  // back to sequential mode, after the memory of the other threads is freed
+  if (n_threads > 1 and taped){
+    thread_tapes.clear();
+    parallel_ad_teardown(n_threads);
+  }
+#endif
+  // the culled restarts stopped early, they are not candidates
+  arma::vec candidate_vals = results.obj_func_vals;
+  for (unsigned m = 0; m < n_sols; m++)
+    if (results.race != nullptr and results.race->culled(m))
+      candidate_vals(m) = arma::datum::inf;
+  unsigned best_idx = std::distance(candidate_vals.cbegin(), 
                                     std::min_element(
-                                       results.obj_func_vals.cbegin(),
-                                       results.obj_func_vals.cend()
+                                       candidate_vals.cbegin(),
+                                       candidate_vals.cend()
                                                     )
                                       );
-#ifndef MYNDEBUG
-  
-  std::cout << "Sending out solutions list "  << std::endl;
-  std::cout << "Depth: " <<  orct_ptr->depth << std::endl;
-  std::cout << "n_feats: " <<  orct_ptr->n_feats << std::endl;
-  std::cout << "n_labels: " <<  orct_ptr->n_labels << std::endl;
-  std::cout << "best_idx: " <<  best_idx << std::endl;
-#endif
+  span->set_result("best_obj", candidate_vals(best_idx));
     
+  results.alpha = this->alpha;
+  results.best_idx = best_idx;
+  results.tape_seconds = taped ? this->optimiser->tape->record_seconds : 0.;
+  if (taped){
+    const auto& fun = this->optimiser->tape->fun;
+    results.tape_ops = fun.size_op();
+    results.tape_vars = fun.size_var();
+    results.tape_bytes = fun.size_op_seq();
+  }
+  std::chrono::duration<double> optimise_elapsed = std::chrono::steady_clock::now() - 
+    optimise_start;
+  results.optimise_seconds = optimise_elapsed.count();
+  results.peak_rss_bytes = helpers::peak_rss_bytes();
+  span.reset();
+  if (from_r)  // the threads are done
+    Trace::flush();
+  return results;
+}
+
+Rcpp::List FdPot::results_list(const FdPotResults& results) const{
+  for (const auto& error: results.errors)
+    if (not error.empty())
+      Rcpp::Rcout << error << std::endl;
+  const unsigned best_idx = results.best_idx;
+  const SolverConfig config = this->solver_config.effective(this->backend);
+  
+  // where the time and the memory went
+  Rcpp::NumericVector stage_seconds = Rcpp::NumericVector::create(
+    _("features") = this->stage_seconds(0), _("dissim") = this->stage_seconds(1),
+    _("setup") = this->stage_seconds(2), _("tape") = results.tape_seconds,
+    _("optimise") = results.optimise_seconds);
+  Rcpp::IntegerMatrix evaluations = Rcpp::wrap(results.evaluations);
+  Rcpp::colnames(evaluations) = Rcpp::CharacterVector::create(
+    "iterations", "obj", "constr", "grad", "jac", "hess");
+  Rcpp::CharacterVector status(results.status.n_elem);
+  for (unsigned m = 0; m < results.status.n_elem; m++)
+    status[m] = status_name(static_cast<
+      CppAD::ipopt::solve_result<arma::vec>::status_type>(results.status(m)));
+  Rcpp::List telemetry = Rcpp::List::create(
+    _("stage_seconds") = stage_seconds,
+    _("restart_seconds") = results.solve_seconds,
+    _("evaluations") = evaluations,
+    _("status") = status,
+    _("cart_start") = results.cart_start,
+    _("tape_ops") = results.tape_ops,
+    _("tape_vars") = results.tape_vars,
+    _("tape_bytes") = results.tape_bytes,
+    _("peak_rss_bytes") = results.peak_rss_bytes
+  );
+  
   return Rcpp::List::create(
+    _("alpha") = results.alpha,
     _("depth") = orct_ptr->depth,
     _("n_feats") = orct_ptr->n_feats,
     _("n_labels") = orct_ptr->n_labels,
@@ -385,6 +926,14 @@ Rcpp::List FdPot::solve_trees(void){
     _("obj_func_vals") = results.obj_func_vals,
     _("cost_func_vals") = results.cost_func_vals,
     _("penalty_func_vals") = results.penalty_func_vals,
+    _("n_active_weights") = results.n_active_weights,
+    _("l1_lambda") = this->l1_lambda,
+    _("sparsity_tol") = this->sparsity_tol,
+    _("tape_seconds") = results.tape_seconds,
+    _("solve_seconds") = results.solve_seconds,
+    _("solver_options") = config.to_list(this->backend),
+    _("racing") = results.race != nullptr ? results.race->report() : Rcpp::List(),
+    _("telemetry") = telemetry,
     _("all_variables") = results.all_variables,
     _("best_variables") = results.all_variables.col(best_idx)
     
@@ -394,21 +943,28 @@ Rcpp::List FdPot::solve_trees(void){
   );
 };
 
-void FdPot::scale_features(arma::mat& features){
-    #ifndef MYNDEBUG
-      std::cout << "Scaling features" << std::endl;
-    #endif
-    #ifdef DEV
-        Rcpp::Rcout << "Scaling features" << std::endl;
-    #endif
+namespace {
+/*! @brief MinMax scaling of the columns of a features matrix
+@tparam MatT either arma::mat or arma::fmat
+*/
+template<typename MatT>
+void minmax_scale(MatT& features){
     // perform MinMax scaling
     for (unsigned p = 0; p < features.n_cols; p++){
-      double colmax = features.col(p).max();
-      double colmin = features.col(p).min();
+      auto colmax = features.col(p).max();
+      auto colmin = features.col(p).min();
       
       features.col(p) = (features.col(p) - colmin) / (colmax - colmin);
     }
-};
-
+}
+} // anonymous namespace
 
+void FdPot::scale_features(arma::mat& features){
+    Trace::event(Trace::Level::DEBUG, "scale_features", "n_rows", features.n_rows,
+                 "n_cols", features.n_cols);
+    minmax_scale(features);
+};
 
+void FdPot::scale_features(arma::fmat& features){
+    minmax_scale(features);
+};
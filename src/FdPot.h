@@ -1,6 +1,7 @@
 #ifndef p_fdorct
 #define p_fdorct
 
+#include <algorithm>
 #include <cmath>
 #include <tuple>
 #include <random>
@@ -8,8 +9,11 @@
 #include <omp.h>
  
 #include "BasisObj.h"
+#include "Checkpoint.h"
 #include "OptimHandler.h"
+#include "RestartRace.h"
 #include "ORCT.h"
+#include "QuadFormAtomic.h"
 #include "helpers.h"
 #include "FdPotSupport.h"
 #include "dirichlet.h"
@@ -28,6 +32,12 @@ public:
 @param alpha_ the penalisation weight
 @param seed_ the seed for the different initialisation points
 @param gamma_ randomisation factor, best left unchanged
+@param l1_lambda_ weight of the L1 penalty on the split weights (0 disables it)
+@param sparsity_tol_ split weights below this tolerance are set to 0 after the fit, if l1_lambda_ > 0
+@param n_threads_ how many restarts are solved concurrently (OpenMP); 1 if
+the linear solver of Ipopt is not thread-safe (see SolverConfig::concurrent_solves)
+@param backend_ how Ipopt gets the derivatives (see OptimBackend)
+@param solver_config_ the Ipopt options (see SolverConfig)
 
 */
     FdPot(splines2::BSpline&& basis_,
@@ -37,12 +47,24 @@ public:
           const unsigned int depth_,
           const double alpha_,
           const unsigned long int seed_ = 22200337,
-          const double gamma_=512.) : 
+          const double gamma_=512.,
+          const double l1_lambda_ = 0.,
+          const double sparsity_tol_ = 1e-4,
+          const unsigned n_threads_ = 1,
+          const OptimBackend backend_ = OptimBackend::CPPAD,
+          const SolverConfig& solver_config_ = SolverConfig()) : 
     orct_ptr{std::make_unique<ORCT>(depth_, n_feats, n_labels, gamma_)},
     evalFd{std::move(basis_)},
     n_samples(n_samples_),
-    alpha{alpha_}, 
-    seed{seed_}
+    alpha{alpha_},
+    alpha_ad{alpha_}, 
+    seed{seed_},
+    l1_lambda{l1_lambda_},
+    sparsity_tol{sparsity_tol_},
+    // one thread, if the linear solver is not thread-safe
+    n_threads{std::max(solver_config_.solve_threads(n_threads_, backend_), 1u)},
+    backend{backend_},
+    solver_config{solver_config_}
     {};
     
     /*! @brief Calls different methods to orchestrate fitting
@@ -53,12 +75,143 @@ public:
     */
     Rcpp::List fit(const arma::vec& y, const arma::mat& X_coeff, const unsigned n_sols = 20);
     
+    /*! @brief Fits the tree for a sequence of penalisation weights
+    
+    Features, dissimilarities and the tape are computed once; alpha is a 
+    dynamic parameter of the tape. The solutions for an alpha (variables and
+    Ipopt multipliers) are the starting points of the next one.
+    @param y the labels vector
+    @param X_coeff the coefficients matrix of the smoothing
+    @param alphas the penalisation weights, best sorted
+    @param n_sols the number of solutions per alpha
+    @return an Rcpp::List with the results of fit for each alpha
+    */
+    Rcpp::List fit_path(const arma::vec& y, const arma::mat& X_coeff,
+                        const arma::vec& alphas, const unsigned n_sols = 20);
+    
+    /*! @brief Fits the tree again once new samples are appended to its data
+    
+    The features and the dissimilarities of the previous samples are read 
+    from the checkpoint data (see set_checkpoint): only the ones of the new 
+    samples are computed, and the extended data are written back, for the 
+    next refit. Without them, everything is computed. The restarts start 
+    from the solutions of the previous fit.
+    @param y the labels of all the samples, the previous ones first
+    @param X_coeff the coefficients of all the samples, the previous ones first
+    @param n_new how many samples (the last ones) are new
+    @param start_vars the solutions of the previous fit, one per column (the
+    restarts without one, or whose one is not finite, start as in fit)
+    @param n_sols the number of solutions
+    @return an Rcpp::List with the fitting results
+    */
+    Rcpp::List refit(const arma::vec& y, const arma::mat& X_coeff, const unsigned n_new,
+                     const arma::mat& start_vars, const unsigned n_sols = 20);
+    
+    /*! @brief The objective and its gradient at random points, as Ipopt gets
+    them from the backend (the tape with CPPAD, OrctObjective otherwise)
+    
+    Nothing is solved: it is meant to check the backends against each other.
+    @param y the labels vector
+    @param X_coeff the coefficients matrix of the smoothing
+    @param n_points the number of points, drawn as the random starting 
+    points of the restarts (the same for every backend)
+    @return an Rcpp::List with the points, the values and the gradients (one
+    column per point)
+    */
+    Rcpp::List derivatives(const arma::vec& y, const arma::mat& X_coeff,
+                           const unsigned n_points);
+    
+    /*! @brief Sets the problem up on precomputed features and dissimilarities
+    
+    The alternative to the set up of fit when the features and the 
+    dissimilarities of the samples are shared by several trees (e.g. by the 
+    folds of CrossValidation). Must be called from R's thread, since it 
+    creates a CppAD atomic function; then optimise can run in any thread.
+    @param y the labels vector, referenced by the problem: it must outlive it
+    @param raw_features the n_samples x n_feats features, not scaled yet
+    @param dissim the n_samples x n_samples dissimilarity matrix, shared
+    (not copied) by all the trees it is given to
+    @param n_sols the number of solutions
+    */
+    void setup_precomputed(const arma::vec& y, arma::mat&& raw_features,
+                           std::shared_ptr<const arma::mat> dissim,
+                           const unsigned n_sols = 20);
+    
+    /*! @brief Solves the tree from different starting points
+    
+    @param warm_start if not null and not empty, restart m starts from its
+    solution m (and multipliers)
+    @param from_r false if called from a thread other than R's: no R API is 
+    used, the restarts are solved one after the other and CppAD must have 
+    been set up by the caller (see parallel_ad_setup)
+    @return the solutions, see results_list
+    */
+    FdPotResults optimise(FdPotResults* warm_start = nullptr, const bool from_r = true);
+    
+    /*! @brief The results of optimise as the list returned by fit
+    Prints the errors of the failed restarts, if any.
+    */
+    Rcpp::List results_list(const FdPotResults& results) const;
+    
+    /*! @brief Changes the penalisation weight once the problem is set up
+    Updates the dynamic parameter of the tape, or the objective
+    */
+    void set_alpha(const double alpha_);
+    
+    /*! @brief Checkpoints fit to a file, to resume it after an interruption
+    
+    fit saves the features and the dissimilarities once computed, and 
+    optimise the restarts solved so far (see Checkpoint). A fit of the same
+    data and parameters reads them back: the preprocessing is skipped, and 
+    so are the restarts already solved. The basis is not part of the key:
+    use a different file for a different basis.
+    @param path the file, empty to stop checkpointing
+    @param interval_seconds minimum time between two checkpoints of the restarts
+    */
+    void set_checkpoint(const std::string& path, const double interval_seconds = 60.);
+    
+    /*! @brief Solves the restarts in forked worker processes (see ProcessPool)
+    
+    The workers share the set up problem with this process and solve the 
+    restarts one after the other, so that no AD operation runs in parallel in
+    one process; n_threads is then ignored. Only fits called from R's thread
+    use them (not the folds of CrossValidation, the structures of GridSearch
+    or the trees of Forest). The results do not depend on it.
+    @param n_processes_ the number of workers, 0 to solve in this process
+    (the only choice without fork, i.e. on Windows)
+    */
+    void set_processes(const unsigned n_processes_);
+    
+    /*! @brief Frees the recorded tape, if any
+    CppAD gives each thread its own memory: with several threads, the thread
+    that recorded the tape should free it (see CrossValidation).
+    */
+    inline void release_tape(void){ this->optimiser->tape = nullptr; }
+    
+    /*! @brief the structure of the tree (e.g. to grow its solutions, see 
+    ORCT::grow_variables)
+    */
+    inline const ORCT& tree(void) const{ return *this->orct_ptr; }
+    
+    /*! @brief Probabilities of the labels of new samples
+    @param raw_features their features, not scaled yet (they are scaled on 
+    their own, as in predict_FdPot_Rcpp)
+    @param vars the fitted variables
+    @return a n_samples x n_labels matrix
+    */
+    arma::mat predict_probs(arma::mat&& raw_features, const arma::vec& vars) const;
+    
     /*! @brief Scales the features between 0 and 1 
     It is a MinMax Scaler, moving everything to [0,1]
     @param feats  the features matrix
     Note it transforms them in-place (it is void)
     */
     static void scale_features(arma::mat& feats);
+    /*! @brief Single precision overload of scale_features
+    Used by the float inference path
+    @param feats  the features matrix
+    */
+    static void scale_features(arma::fmat& feats);
      /*! @brief Calculates misclassificaton cost
      @param label the actual albel
      @param predicted the predicted label
@@ -73,24 +226,65 @@ public:
     */   
     using VariantVarsT = std::variant<OptimTraits::ADvector, arma::vec>;
 
-    arma::mat dissim_matrix;
+    /*! @brief the dissimilarity matrix, shared by the CppAD atomic and the
+    objective of the problem (and by the problems of the drivers fitting
+    several trees on the same data, see setup_precomputed): never copied
+    */
+    std::shared_ptr<const arma::mat> dissim_matrix = nullptr;
 
     arma::mat features;
+    /*! @brief the scaled features, sample-major (n_feats x n_samples)
+    
+    The transpose of features, read by the loops over the samples of the 
+    objective: the features of a sample are a contiguous column (see 
+    ORCT::FeatT). Set by setup_problem.
+    */
+    arma::mat features_t;
   private:
 
     FdHandler<BasisEnum::BSPLINE> evalFd;  // bridge to value functional data.
 
     std::unique_ptr<ORCT> orct_ptr = nullptr;
 
+    /*! @brief the penalty of a leaf as a single CppAD operation
+    Created in fit, once the dissimilarity matrix is known; declared before
+    the optimiser since it must outlive the tapes.
+    */
+    std::unique_ptr<QuadFormAtomic> leaf_quad_form = nullptr;
+
     std::unique_ptr<OptimHandler> optimiser = std::make_unique<OptimHandler>();
+    
+    /*! @brief the handlers of the restarts, one per solution
+    Kept across the calls of optimise (e.g. along an alpha path) and reset
+    from the optimiser by each one (see OptimHandler::reset_from), so that
+    their buffers are allocated once per fit.
+    */
+    std::vector<OptimHandler> handlers;
+    
+    /*! @brief the objective without tape, for the NATIVE and STOCHASTIC backends */
+    std::shared_ptr<OrctObjective> objective = nullptr;
+    
+    /*! @brief where the fit is checkpointed, if anywhere (see set_checkpoint) */
+    std::unique_ptr<Checkpoint> checkpoint = nullptr;
+    std::uint64_t problem_key = 0;  // key of data and labels, set by setup_fit
+    const arma::vec* labels = nullptr;  // referenced by the problem, set by setup_problem
    
 
   	std::pair<unsigned, unsigned> n_constrs = std::make_pair(0,0); // updated in the fit method
   	unsigned long seed;
   	double alpha;
+  	ADdouble alpha_ad;  // alpha as read by the objective (dynamic parameter of the tape)
   	unsigned n_sols = 0u;
   	double missclaf_cost{0.5}; // misclassification cost, this number was used in the experiments by Blaquero et al.
+  	double l1_lambda{0.};  // weight of the L1 penalty on the split weights
+  	double sparsity_tol{1e-4};  // weights below it are pruned after the fit
+  	double l1_eps{1e-8};  // smoothing of the absolute value, see l1_func
   	unsigned n_samples = 0u;
+  	unsigned n_threads = 1u;  // restarts solved concurrently
+  	unsigned n_processes = 0u;  // worker processes solving the restarts, see set_processes
+  	OptimBackend backend = OptimBackend::CPPAD;  // derivatives given to Ipopt
+  	SolverConfig solver_config;  // Ipopt options
+  	arma::vec::fixed<3> stage_seconds{0., 0., 0.};  // features, dissimilarities, set up
   	// 1Rcpp::String similarity_method; // for the future
   	//////////////////////////////////////////////////////////
 
@@ -102,44 +296,84 @@ public:
       /*! @brief the penalty function pointer
       Updated runtime
     */
-  	std::function<ADdouble(const OptimTraits::ADvector&)> penalty_func = nullptr;
+  	std::function<ADdouble(const VariantVarsT&)> penalty_func = nullptr;
+      /*! @brief the L1 penalty on the split weights
+      The absolute value is smoothed as sqrt(w^2 + eps) - sqrt(eps), so that 
+      Ipopt gets twice differentiable functions; the weights that end up
+      below sparsity_tol are pruned after the optimisation.
+      Updated runtime
+    */
+  	std::function<ADdouble(const OptimTraits::ADvector&)> l1_func = nullptr;
       /*! @brief Objective function
       The linear combination of the expected misclassification cost and the 
-      dissimilarity penalisation.
+      dissimilarity penalisation (plus the L1 penalty, if any).
+      Both terms are fed by a single evaluation of the leaf probabilities.
+      Updated runtime
     */
-  	std::function<ADdouble(const OptimTraits::ADvector&)>  obj_function = \
-  	  [this](const OptimTraits::ADvector& vars) -> ADdouble{
-  	  return this->cost_func(vars) + this->alpha * this->penalty_func(vars);
-   	  };
+  	std::function<ADdouble(const OptimTraits::ADvector&)>  obj_function = nullptr;
+  	
+  	/*! @brief Probabilities of all the samples of falling in every leaf
+  	@tparam VarVecT arma::vec or OptimTraits::ADvector
+  	@param vars the variables
+  	@return column major n_samples x n_leaf_nodes buffer: the probabilities
+  	of a leaf are contiguous
+  	*/
+  	template<typename VarVecT>
+  	std::vector<typename VarVecT::value_type> leaf_probas(const VarVecT& vars) const;
   	
 
-  	 /*! @brief Solves the tree from different starting points
+  	 /*! @brief Solves the tree from different starting points (optimise 
+  	 followed by results_list)
   	 
+  	 @param warm_start if not null and not empty, restart m starts from its
+  	 solution m (and multipliers); on exit it holds the new solutions
   	 @return an Rcpp::List with the results
     	*/
-  	Rcpp::List solve_trees(void);
+  	Rcpp::List solve_trees(FdPotResults* warm_start = nullptr);
+  	
+  	/*! @brief Computes features and dissimilarities, sets up the optimiser
+  	@param y the labels vector
+  	@param X_coeff the coefficients matrix  	
+  	*/
+  	void setup_fit(const arma::vec& y, const arma::mat & X_coeff);
+  	
+  	/*! @brief Creates the atomic penalty and sets up the optimiser, once
+  	features and dissimilarities are known
+  	@param y the labels vector
+  	*/
+  	void setup_problem(const arma::vec& y);
+  	
   
 
   	 /*! @brief Sets up mathematical moment
   	 PRoduces the OPtimFuns to send to the OptimHandler
   	 @note This function utilises the Visitor pattern. 	
   	    @param y the labels vector
-  	    @param X_coeff the coefficients matrix  	
     	*/
-  	OptimTraits::OptimFuns create_mathematical_model(const arma::vec& y, const arma::mat & X_coeff); 
+  	OptimTraits::OptimFuns create_mathematical_model(const arma::vec& y); 
   	
   	/*! @brief Sets up the optimiser member 
   	Sets variable sizes, constraints, variables and constraints bounds
   	@param y the labels vector
-  	@param X_coeff the coefficients matrix  	
         */
-  	void setup_optimiser(const arma::vec& y, const arma::mat & X_coeff);
+  	void setup_optimiser(const arma::vec& y);
   	/*! @brief Initialises, given a fixed seed, the variables vector
   	@param seed the random seed
   	@param vars the vector to alter.        
         */
   	void initialise_vars(std::uint32_t seed, OptimHandler::Dvector & vars);
   	
+  	/*! @brief Key of the checkpoint of the restarts: the data, the labels 
+  	and every parameter that changes the solutions
+  	*/
+  	std::uint64_t fit_key(void) const;
+  	
+  	/*! @brief Key of the checkpointed features and dissimilarities of the
+  	data: the coefficients, the basis, the quadrature and n_feats (see
+  	FdHandler::cache_key)
+  	*/
+  	std::uint64_t data_key(const arma::mat& X_coeff);
+  	
   	
   	
   }; // class FdPot
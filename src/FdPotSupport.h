@@ -1,7 +1,14 @@
 #ifndef FDPOT_SUPPORT_HEADER
 #define FDPOT_SUPPORT_HEADER
+#include <memory>
+#include <string>
+#include <vector>
 #include "BasisObj.h"
 
+namespace fdpot{
+class RestartRace;  // see RestartRace.h
+}
+
 struct FdPotOptions{
   splines2::BSpline basis_;
   
@@ -9,14 +16,43 @@ struct FdPotOptions{
 };
 
 struct FdPotResults{
-  FdPotResults(const unsigned n_sols, const unsigned n_vars):
+  FdPotResults(void) = default;
+  FdPotResults(const unsigned n_sols, const unsigned n_vars,
+               const unsigned n_constraints = 0):
     obj_func_vals(arma::vec(n_sols)), cost_func_vals(arma::vec(n_sols)),
     penalty_func_vals(arma::vec(n_sols)), 
-    all_variables(arma::mat(n_vars, n_sols))
+    all_variables(arma::mat(n_vars, n_sols)),
+    n_active_weights(arma::uvec(n_sols, arma::fill::zeros)),
+    solve_seconds(arma::vec(n_sols, arma::fill::zeros)),
+    all_zl(arma::mat(n_vars, n_sols, arma::fill::zeros)),
+    all_zu(arma::mat(n_vars, n_sols, arma::fill::zeros)),
+    all_lambda(arma::mat(n_constraints, n_sols, arma::fill::zeros)),
+    has_multipliers(arma::uvec(n_sols, arma::fill::zeros)),
+    errors(n_sols),
+    evaluations(arma::Mat<int>(n_sols, 6, arma::fill::zeros)),
+    status(arma::Col<int>(n_sols, arma::fill::zeros)),
+    cart_start(arma::uvec(n_sols, arma::fill::zeros))
   {};
   
   arma::vec obj_func_vals, cost_func_vals, penalty_func_vals, best_variables;
   arma::mat  all_variables;
+  arma::uvec n_active_weights;  // surviving split weights of each solution
+  arma::vec solve_seconds;  // wall time of each restart, tape excluded
+  // Ipopt multipliers of each solution, used to warm start nearby problems
+  arma::mat all_zl, all_zu, all_lambda;
+  arma::uvec has_multipliers;  // 0 if the solver gave none (e.g. stochastic)
+  std::vector<std::string> errors;  // what each restart threw, empty if nothing
+  std::shared_ptr<const fdpot::RestartRace> race = nullptr;  // if the restarts raced
+  double alpha = 0.;  // the penalisation weight of the solutions
+  unsigned best_idx = 0;  // best restart (culled ones excluded)
+  double tape_seconds = 0.;  // recording of the tape, if any
+  // telemetry of the solves
+  arma::Mat<int> evaluations;  // per restart: iterations, f, g, grad f, jac g, hess
+  arma::Col<int> status;  // per restart, a CppAD::ipopt::solve_result status
+  arma::uvec cart_start;  // 1 if the restart started from a greedy tree
+  double optimise_seconds = 0.;  // wall time of optimise, tape included
+  double tape_ops = 0., tape_vars = 0., tape_bytes = 0.;  // size of the tape, if any
+  double peak_rss_bytes = arma::datum::nan;  // of the process, after the solves
   
   
 };
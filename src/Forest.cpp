@@ -0,0 +1,152 @@
+#include "Forest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "MemoryViews.h"
+#include "ParallelAD.h"
+#include "Trace.h"
+
+using Rcpp::_;
+
+namespace fdpot{
+
+Rcpp::List Forest::fit(const arma::vec& y, const arma::mat& X_coeff, const unsigned n_trees,
+                       const unsigned n_sols, const std::uint32_t seed){
+  const unsigned n_samples = y.n_elem;
+
+  // shared by all the trees
+  auto start = std::chrono::steady_clock::now();
+  const arma::mat features = this->fd_handler.compute_features(X_coeff, this->n_feats);
+  std::chrono::duration<double> features_seconds = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  const arma::mat dissim = this->fd_handler.compute_dissim_matrix(X_coeff);
+  std::chrono::duration<double> dissim_seconds = std::chrono::steady_clock::now() - start;
+
+  // bootstrap samples and feature subsets, drawn before fitting: they do
+  // not depend on the number of threads
+  std::vector<arma::uvec> samples(n_trees);
+  arma::umat feature_idx(this->tree_feats, n_trees);
+  Rcpp::IntegerMatrix in_bag(n_samples, n_trees);  // returned as is, zeroed
+  std::vector<arma::uword> all_feats(this->n_feats);
+  for (unsigned t = 0; t < n_trees; t++){
+    std::mt19937 engine{seed + t};
+    std::uniform_int_distribution<arma::uword> draw(0, n_samples - 1);
+    samples[t].set_size(n_samples);
+    for (auto& i: samples[t]){
+      i = draw(engine);
+      in_bag(i, t)++;
+    }
+    std::iota(all_feats.begin(), all_feats.end(), 0);
+    std::shuffle(all_feats.begin(), all_feats.end(), engine);
+    std::sort(all_feats.begin(), all_feats.begin() + this->tree_feats);
+    for (unsigned j = 0; j < this->tree_feats; j++)
+      feature_idx(j, t) = all_feats[j];
+  }
+
+  Rcpp::NumericMatrix variables(0, 0);  // written through mat_view, once sized
+  arma::vec obj_func_vals(n_trees), setup_seconds(n_trees, arma::fill::zeros),
+    fit_seconds(n_trees, arma::fill::zeros);
+  obj_func_vals.fill(arma::datum::nan);
+  std::vector<std::string> errors(n_trees);
+  const unsigned n_threads = std::min(this->n_threads, n_trees);
+  const bool from_r = n_threads == 1;
+
+  for (unsigned wave = 0; wave < n_trees; wave += n_threads){
+    const unsigned wave_end = std::min(wave + n_threads, n_trees);
+    // the set up creates CppAD atomic functions: one tree after the other
+    std::vector<arma::vec> y_boot(wave_end - wave);  // referenced by the trees
+    std::vector<std::unique_ptr<FdPot>> trees(wave_end - wave);
+    for (unsigned t = wave; t < wave_end; t++){
+      start = std::chrono::steady_clock::now();
+      const arma::uvec& rows = samples[t];
+      y_boot[t - wave] = y.elem(rows);
+      trees[t - wave] = this->make_tree(n_samples, this->tree_feats, seed + t);
+      trees[t - wave]->setup_precomputed(y_boot[t - wave],
+                                         arma::mat(features.submat(rows, feature_idx.col(t))),
+                                         std::make_shared<const arma::mat>(
+                                           dissim.submat(rows, rows)), n_sols);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      setup_seconds(t) = elapsed.count();
+    }
+
+    // one tree per thread: no R API and CppAD in parallel mode
+    std::vector<FdPotResults> fits(wave_end - wave);
+    parallel_ad_setup(n_threads);
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic) if(n_threads > 1)
+    for (unsigned t = wave; t < wave_end; t++){
+      try{
+        auto tree_start = std::chrono::steady_clock::now();
+        fits[t - wave] = trees[t - wave]->optimise(nullptr, from_r);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - tree_start;
+        fit_seconds(t) = elapsed.count();
+      }
+      catch (const std::exception& e){  // nothing may leave the parallel region
+        errors[t] = e.what();
+      }
+      // the memory of the tape goes back to the thread that allocated it
+      trees[t - wave]->release_tape();
+    }
+    parallel_ad_teardown(n_threads);
+    Trace::flush();  // the events of the threads
+
+    for (unsigned t = wave; t < wave_end; t++){
+      const auto& fit = fits[t - wave];
+      if (variables.nrow() == 0 and not fit.all_variables.is_empty()){
+        variables = Rcpp::NumericMatrix(fit.all_variables.n_rows, n_trees);
+        std::fill(variables.begin(), variables.end(), arma::datum::nan);
+      }
+      if (not errors[t].empty())
+        Rcpp::Rcout << "tree " << t << ": " << errors[t] << std::endl;
+      else if (std::isfinite(fit.obj_func_vals(fit.best_idx))){
+        mat_view(variables).col(t) = fit.all_variables.col(fit.best_idx);
+        obj_func_vals(t) = fit.obj_func_vals(fit.best_idx);
+      }
+    }
+    Rcpp::checkUserInterrupt();  // between waves
+  }
+
+  return Rcpp::List::create(
+    _("n_trees") = n_trees,
+    _("n_feats") = this->n_feats,
+    _("tree_feats") = this->tree_feats,
+    _("variables") = variables,
+    _("feature_idx") = feature_idx,
+    _("obj_func_vals") = obj_func_vals,
+    _("in_bag") = in_bag,
+    _("errors") = errors,
+    _("features_seconds") = features_seconds.count(),
+    _("dissim_seconds") = dissim_seconds.count(),
+    _("setup_seconds") = setup_seconds,
+    _("fit_seconds") = fit_seconds,
+    _("n_threads") = n_threads
+  );
+}
+
+void Forest::predict_probs(const arma::mat& features, const ORCT& tree,
+                           const arma::mat& variables, const arma::umat& feature_idx,
+                           arma::mat& probs){
+  probs.zeros();
+  unsigned n_used = 0;
+  for (unsigned t = 0; t < variables.n_cols; t++){
+    if (not variables.col(t).is_finite())
+      continue;
+    // the scaling is by column: the columns of the scaled features are the
+    // scaled features of the tree
+    probs += tree.predict_probs(arma::mat(features.cols(feature_idx.col(t))),
+                                arma::vec(variables.col(t)));
+    n_used++;
+  }
+  if (n_used == 0)
+    Rcpp::stop("no tree of the forest was fitted");
+  probs /= n_used;
+}
+
+} // namespace fdpot
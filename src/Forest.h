@@ -0,0 +1,87 @@
+#ifndef FOREST_HH
+#define FOREST_HH
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "RcppArmadillo.h"
+#include "BasisObj.h"
+#include "FdPot.h"
+#include "ORCT.h"
+
+namespace fdpot{
+
+/*! @brief Bagged forest of FD-POTs
+
+ @description Each tree is fitted on a bootstrap sample of the data and on
+ a random subset of the features. The features and the dissimilarity
+ matrix are computed once for the whole dataset, and each tree takes the
+ rows (and columns) of its sample by index, as the folds of
+ CrossValidation do.
+ The trees are fitted in waves of n_threads: the trees of a wave are set
+ up one after the other (see FdPot::setup_precomputed), solved
+ concurrently, one per OpenMP thread, and destroyed once their best
+ solution is kept, so that at most n_threads problems are in memory.
+ The fitted forest is the best variables of each tree together with its
+ features: predict_probs averages the probabilities of the trees.
+ */
+class Forest{
+public:
+  /*! @brief Creates the (not fitted) tree given its number of samples and
+   of features and its seed
+   */
+  using TreeFactory = std::function<std::unique_ptr<FdPot>(
+    const unsigned n_samples, const unsigned n_feats, const std::uint32_t seed)>;
+
+  /*! @brief Constructor
+   @param fd_handler_ computes features and dissimilarities
+   @param n_feats_ the number of features computed for each sample
+   @param tree_feats_ the number of them each tree uses (at most n_feats_)
+   @param make_tree_ creates the tree of each bootstrap sample
+   @param n_threads_ how many trees are solved concurrently; with more than
+   one, the restarts of each tree are solved one after the other
+   */
+  Forest(FdHandler<BasisEnum::BSPLINE>&& fd_handler_, const unsigned n_feats_,
+         const unsigned tree_feats_, TreeFactory make_tree_, const unsigned n_threads_ = 1):
+    fd_handler(std::move(fd_handler_)), n_feats(n_feats_),
+    tree_feats(std::min(tree_feats_, n_feats_)), make_tree(std::move(make_tree_)),
+    n_threads(std::max(n_threads_, 1u)) {};
+
+  /*! @brief Fits the trees
+   @param y the labels
+   @param X_coeff the coefficients matrix of the smoothing
+   @param n_trees the number of trees
+   @param n_sols the number of restarts of each tree
+   @param seed the seed of the bootstrap samples and of the feature subsets;
+   tree t is fitted with seed + t
+   @return the best variables of each tree (one column per tree, NaN if its
+   fit failed), its features (tree_feats x n_trees, 0-based), its objective
+   and its in-bag samples (how many times each sample was drawn, n_samples x
+   n_trees), with the time spent on the shared artefacts and on each tree
+   */
+  Rcpp::List fit(const arma::vec& y, const arma::mat& X_coeff, const unsigned n_trees,
+                 const unsigned n_sols, const std::uint32_t seed);
+
+  /*! @brief Mean of the probabilities of the trees
+   @param features the features of the samples, already scaled (see
+   FdPot::scale_features), all the n_feats of them
+   @param tree the structure shared by the trees (with tree_feats features)
+   @param variables the best variables of each tree, see fit
+   @param feature_idx the features of each tree, see fit
+   @param probs the n_samples x n_labels output (e.g. a view of an R
+   matrix, see mat_view); trees with non finite variables are skipped
+   */
+  static void predict_probs(const arma::mat& features, const ORCT& tree,
+                            const arma::mat& variables, const arma::umat& feature_idx,
+                            arma::mat& probs);
+
+private:
+  FdHandler<BasisEnum::BSPLINE> fd_handler;
+  const unsigned n_feats, tree_feats;
+  TreeFactory make_tree;
+  const unsigned n_threads;
+};
+
+} // namespace fdpot
+
+#endif
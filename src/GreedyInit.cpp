@@ -0,0 +1,89 @@
+#include "GreedyInit.h"
+#include <random>
+#include <vector>
+
+namespace fdpot{
+
+void GreedyInit::initialise(const arma::uvec& samples, arma::vec& vars) const{
+  vars.zeros(this->tree.n_vars);
+  this->grow(0, samples, vars);
+}
+
+void GreedyInit::initialise(const std::uint32_t seed, arma::vec& vars) const{
+  const arma::uword n_samples = this->y.n_elem;
+  if (seed == 0){
+    this->initialise(arma::regspace<arma::uvec>(0, n_samples - 1), vars);
+    return;
+  }
+  std::mt19937 engine{seed};
+  std::uniform_int_distribution<arma::uword> draw(0, n_samples - 1);
+  arma::uvec samples(n_samples);
+  for (auto& i: samples)
+    i = draw(engine);
+  this->initialise(samples, vars);
+}
+
+void GreedyInit::grow(const unsigned tau, const arma::uvec& samples, arma::vec& vars) const{
+  const unsigned n_labels = this->tree.n_labels, n_feats = this->tree.n_feats;
+  const unsigned first_idx = this->tree.var_map(tau);
+
+  if (tau >= this->tree.n_int_nodes){  // leaf: frequencies of the labels
+    if (samples.is_empty()){
+      vars.subvec(first_idx, first_idx + n_labels - 1).fill(1. / n_labels);
+      return;
+    }
+    for (auto i: samples)
+      vars(first_idx + static_cast<unsigned>(this->y(i))) += 1.;
+    vars.subvec(first_idx, first_idx + n_labels - 1) /= samples.n_elem;
+    return;
+  }
+
+  arma::vec total(n_labels, arma::fill::zeros);
+  for (auto i: samples)
+    total(static_cast<unsigned>(this->y(i))) += 1.;
+
+  // the best split maximises sum_k l_k^2 / n_l + sum_k r_k^2 / n_r, i.e.
+  // minimises the weighted Gini impurity of the children
+  unsigned best_feat = 0;
+  double best_theta = samples.is_empty() ? 0.5 :
+    arma::median(arma::vec(this->features.col(0).eval().elem(samples)));
+  double best_score = -1.;
+  if (arma::accu(total > 0.) > 1){  // nothing to separate otherwise
+    arma::vec left(n_labels);
+    for (unsigned j = 0; j < n_feats; j++){
+      const arma::vec x = this->features.col(j).eval().elem(samples);
+      const arma::uvec order = arma::sort_index(x);
+      left.zeros();
+      double left_sq = 0., right_sq = arma::accu(arma::square(total));
+      for (arma::uword s = 0; s + 1 < order.n_elem; s++){
+        const unsigned k = static_cast<unsigned>(this->y(samples(order(s))));
+        // move sample s from the right to the left child
+        left_sq += 2. * left(k) + 1.;
+        right_sq -= 2. * (total(k) - left(k)) - 1.;
+        left(k) += 1.;
+        const double x_s = x(order(s)), x_next = x(order(s + 1));
+        if (x_next <= x_s)
+          continue;  // no threshold between equal values
+        const double n_left = s + 1., n_right = order.n_elem - n_left;
+        const double score = left_sq / n_left + right_sq / n_right;
+        if (score > best_score){
+          best_score = score;
+          best_feat = j;
+          best_theta = 0.5 * (x_s + x_next);
+        }
+      }
+    }
+  }
+
+  // x_j < theta goes left: (theta - x_j) / n_feats > 0
+  vars(first_idx + best_feat) = -1.;
+  vars(first_idx + n_feats) = -best_theta / n_feats;
+
+  std::vector<arma::uword> go_left, go_right;
+  for (auto i: samples)
+    (this->features(i, best_feat) < best_theta ? go_left : go_right).push_back(i);
+  this->grow(2 * tau + 1, arma::uvec(go_left), vars);
+  this->grow(2 * tau + 2, arma::uvec(go_right), vars);
+}
+
+} // namespace fdpot
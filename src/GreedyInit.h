@@ -0,0 +1,61 @@
+#ifndef GREEDY_INIT_HH
+#define GREEDY_INIT_HH
+#include <cstdint>
+
+#include "RcppArmadillo.h"
+#include "ORCT.h"
+
+namespace fdpot{
+
+/*! @brief Starting points of the ORCT from a greedy (CART) tree
+
+ @description Grows an axis-aligned classification tree of the same depth
+ on the scaled features, choosing at each node the split with the lowest
+ weighted Gini impurity, and writes it in the layout of the ORCT variables
+ (see ORCT::var_map):
+ - the split "x_j < theta goes left" of an interior node becomes the weight
+ -1 on feature j (0 on the others) and the intercept -theta / n_feats, so
+ that the argument of the cdf is (theta - x_j) / n_feats (see
+ ORCT::proba_go_left);
+ - the variables of a leaf are the frequencies of the labels of the samples
+ that reach it (uniform if none does).
+ Nodes without samples, or whose samples have a single label, get a split
+ at the median of the first feature (0.5 without samples). It sends about
+ half of the samples to each side, but it is harmless: both children get
+ the label frequencies of the node, hence predict as it does (a child that
+ no sample reaches, e.g. with ties at the median, is uniform).
+ */
+class GreedyInit{
+public:
+  /*! @brief Constructor
+   @param tree_ the structure of the ORCT
+   @param features_ the scaled features, n_samples x n_feats (not owned)
+   @param y_ the labels (not owned)
+   */
+  GreedyInit(const ORCT& tree_, const arma::mat& features_, const arma::vec& y_):
+    tree(tree_), features(features_), y(y_) {};
+
+  /*! @brief Writes the greedy tree of some samples in vars
+   @param samples the samples to grow the tree on, repetitions allowed
+   (e.g. a bootstrap sample)
+   @param vars the ORCT variables, of size ORCT::n_vars
+   */
+  void initialise(const arma::uvec& samples, arma::vec& vars) const;
+
+  /*! @brief Same as initialise, on a bootstrap sample drawn with a seed
+   (on all the samples, in order, if seed is 0)
+   */
+  void initialise(const std::uint32_t seed, arma::vec& vars) const;
+
+private:
+  const ORCT& tree;
+  const arma::mat& features;
+  const arma::vec& y;
+
+  /*! @brief Grows node tau on its samples, then its children */
+  void grow(const unsigned tau, const arma::uvec& samples, arma::vec& vars) const;
+};
+
+} // namespace fdpot
+
+#endif
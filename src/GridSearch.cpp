@@ -0,0 +1,130 @@
+#include "GridSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ParallelAD.h"
+#include "Trace.h"
+#include "helpers.h"
+
+using Rcpp::_;
+
+namespace fdpot{
+
+Rcpp::List GridSearch::run(const arma::vec& y, const arma::mat& X_coeff,
+                           const arma::uvec& depths, const arma::uvec& n_feats,
+                           const arma::vec& alphas, const unsigned n_sols,
+                           const bool warm_start){
+  const unsigned n_alphas = alphas.n_elem, n_samples = y.n_elem;
+
+  // once for the whole grid
+  auto start = std::chrono::steady_clock::now();
+  // held once, shared by the problems of all the structures
+  const auto dissim = std::make_shared<const arma::mat>(
+    this->fd_handler.compute_dissim_matrix(X_coeff));
+  std::chrono::duration<double> dissim_seconds = std::chrono::steady_clock::now() - start;
+
+  // once per n_feats
+  std::vector<arma::mat> features(n_feats.n_elem);
+  arma::vec features_seconds(n_feats.n_elem);
+  for (unsigned j = 0; j < n_feats.n_elem; j++){
+    start = std::chrono::steady_clock::now();
+    features[j] = this->fd_handler.compute_features(X_coeff, n_feats(j));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    features_seconds(j) = elapsed.count();
+  }
+
+  // once per structure; the set up creates CppAD atomic functions, hence
+  // the structures are set up one after the other
+  const unsigned n_structs = depths.n_elem * n_feats.n_elem;
+  std::vector<std::unique_ptr<FdPot>> trees(n_structs);
+  arma::vec setup_seconds(n_structs), cost(n_structs);
+  for (unsigned d = 0; d < depths.n_elem; d++)
+    for (unsigned j = 0; j < n_feats.n_elem; j++){
+      const unsigned s = d * n_feats.n_elem + j;
+      start = std::chrono::steady_clock::now();
+      trees[s] = this->make_tree(depths(d), n_feats(j));
+      trees[s]->setup_precomputed(y, arma::mat(features[j]), dissim, n_sols);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      setup_seconds(s) = elapsed.count();
+      // per evaluation: the penalty of every leaf and the splits of every sample
+      const double n_leaves = helpers::n_leaf_nodes(depths(d));
+      cost(s) = n_leaves * n_samples * n_samples +
+        (n_leaves - 1.) * n_feats(j) * n_samples;
+    }
+
+  // the most expensive structures first, so that the cheap ones fill the gaps
+  const arma::uvec order = arma::sort_index(cost, "descend");
+  const unsigned n_threads = std::min(this->n_threads, n_structs);
+  const bool from_r = n_threads == 1;
+  std::vector<FdPotResults> fits(n_structs * n_alphas);
+  arma::vec solve_seconds(n_structs * n_alphas, arma::fill::zeros);
+  std::vector<std::string> errors(n_structs * n_alphas);  // per cell
+  parallel_ad_setup(n_threads);
+  #pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1) if(n_threads > 1)
+  for (unsigned k = 0; k < n_structs; k++){
+    const unsigned s = order(k);
+    // empty: the first alpha starts from random points; a failed alpha is
+    // skipped, the next one starts from the last solved one
+    FdPotResults previous;
+    for (unsigned a = 0; a < n_alphas; a++){
+      const unsigned c = s * n_alphas + a;
+      auto cell_start = std::chrono::steady_clock::now();
+      try{
+        trees[s]->set_alpha(alphas(a));
+        fits[c] = trees[s]->optimise(warm_start ? &previous : nullptr, from_r);
+        if (warm_start)
+          previous = fits[c];
+      }
+      catch (const std::exception& e){  // nothing may leave the parallel region
+        errors[c] = e.what();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - cell_start;
+      solve_seconds(c) = elapsed.count();
+    }
+    // the memory of the tape goes back to the thread that allocated it
+    trees[s]->release_tape();
+  }
+  parallel_ad_teardown(n_threads);
+  Trace::flush();  // the events of the threads
+
+  Rcpp::List cells(n_structs * n_alphas);
+  for (unsigned d = 0; d < depths.n_elem; d++)
+    for (unsigned j = 0; j < n_feats.n_elem; j++){
+      const unsigned s = d * n_feats.n_elem + j;
+      for (unsigned a = 0; a < n_alphas; a++){
+        const unsigned c = s * n_alphas + a;
+        if (not errors[c].empty())
+          Rcpp::Rcout << "depth " << depths(d) << ", n_feats " << n_feats(j) <<
+            ", alpha " << alphas(a) << ": " << errors[c] << std::endl;
+        cells[c] = Rcpp::List::create(
+          _("depth") = depths(d),
+          _("n_feats") = n_feats(j),
+          _("alpha") = alphas(a),
+          _("solve_seconds") = solve_seconds(c),
+          _("error") = errors[c],
+          _("fit_results") = errors[c].empty() ?
+            trees[s]->results_list(fits[c]) : Rcpp::List()
+        );
+      }
+    }
+
+  return Rcpp::List::create(
+    _("cells") = cells,
+    _("dissim_seconds") = dissim_seconds.count(),
+    _("features_seconds") = features_seconds,
+    _("setup_seconds") = setup_seconds,
+    _("n_dissim") = 1,
+    _("n_features") = n_feats.n_elem,
+    _("n_tapes") = n_structs,
+    _("n_cells") = n_structs * n_alphas,
+    _("n_threads") = n_threads
+  );
+}
+
+} // namespace fdpot
@@ -0,0 +1,70 @@
+#ifndef GRID_SEARCH_HH
+#define GRID_SEARCH_HH
+#include <functional>
+#include <memory>
+
+#include "RcppArmadillo.h"
+#include "BasisObj.h"
+#include "FdPot.h"
+
+namespace fdpot{
+
+/*! @brief Grid search over depth x n_feats x alpha
+
+ @description Each artefact of a fit is computed at the level of the grid
+ it depends on:
+ - the dissimilarity matrix only depends on the data: once;
+ - the features depend on n_feats: once per value;
+ - the tape depends on the structure of the tree (depth, n_feats and the
+ number of labels): once per pair (depth, n_feats);
+ - alpha only changes the weight of the penalty, a dynamic parameter of the
+ tape (see FdPot::set_alpha).
+
+ A structure and all its alphas are a task: the alphas are solved one
+ after the other (warm started from the previous one, if asked, as in
+ FdPot::fit_path), while the tasks run concurrently, one per OpenMP thread,
+ the most expensive ones first.
+ */
+class GridSearch{
+public:
+  /*! @brief Creates the (not fitted) tree of a structure */
+  using TreeFactory = std::function<std::unique_ptr<FdPot>(const unsigned depth,
+                                                           const unsigned n_feats)>;
+
+  /*! @brief Constructor
+   @param fd_handler_ computes features and dissimilarities
+   @param make_tree_ creates the tree of each structure
+   @param n_threads_ how many structures are solved concurrently; with more
+   than one, the restarts of each fit are solved one after the other
+   */
+  GridSearch(FdHandler<BasisEnum::BSPLINE>&& fd_handler_, TreeFactory make_tree_,
+             const unsigned n_threads_ = 1):
+    fd_handler(std::move(fd_handler_)), make_tree(std::move(make_tree_)),
+    n_threads(std::max(n_threads_, 1u)) {};
+
+  /*! @brief Fits every cell of the grid
+   @param y the labels
+   @param X_coeff the coefficients matrix of the smoothing
+   @param depths, n_feats, alphas the values of the grid
+   @param n_sols the number of restarts of each cell
+   @param warm_start whether the alphas of a structure are warm started
+   from the previous one (in the given order); an alpha whose fit fails is
+   skipped, the next one starts from the last one solved
+   @return the cells (depth, n_feats, alpha, fit_results as returned by
+   FdPot::fit, solve time, and the error of the cell, if its fit failed) in the order depth, n_feats, alpha (the last
+   varies fastest), and the time spent on each shared artefact
+   */
+  Rcpp::List run(const arma::vec& y, const arma::mat& X_coeff,
+                 const arma::uvec& depths, const arma::uvec& n_feats,
+                 const arma::vec& alphas, const unsigned n_sols,
+                 const bool warm_start = true);
+
+private:
+  FdHandler<BasisEnum::BSPLINE> fd_handler;
+  TreeFactory make_tree;
+  const unsigned n_threads;
+};
+
+} // namespace fdpot
+
+#endif
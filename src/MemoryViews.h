@@ -0,0 +1,49 @@
+#ifndef MEMORY_VIEWS_HH
+#define MEMORY_VIEWS_HH
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief Armadillo matrices over memory they do not own
+
+ @description The data crossing the R boundary are not copied: the
+ arguments of type const arma::mat& of the exported functions already
+ alias the R matrices (RcppArmadillo builds them with the non-copying
+ constructor, for double storage), and these views do the same for the
+ matrices read from lists and for the results, which are written in place
+ in R matrices allocated beforehand. All the views are strict: they can
+ neither be resized nor reallocated, and must not outlive the memory.
+ */
+
+/*! @brief View of an R numeric matrix, to read it or write into it */
+inline arma::mat mat_view(Rcpp::NumericMatrix& m){
+  return arma::mat(m.begin(), m.nrow(), m.ncol(), false, true);
+}
+
+/*! @brief Read-only view of an R numeric matrix */
+inline const arma::mat mat_view(const Rcpp::NumericMatrix& m){
+  return arma::mat(const_cast<double*>(m.begin()), m.nrow(), m.ncol(), false, true);
+}
+
+/*! @brief View of an R numeric vector */
+inline arma::vec vec_view(Rcpp::NumericVector& v){
+  return arma::vec(v.begin(), v.size(), false, true);
+}
+
+/*! @brief Read-only view of consecutive columns of a matrix, which are
+ contiguous in memory (unlike the subviews of Armadillo, it binds to
+ const arma::mat&)
+ @param m the matrix
+ @param first_col the first column
+ @param n_cols how many columns
+ */
+inline const arma::mat cols_view(const arma::mat& m, const arma::uword first_col,
+                                 const arma::uword n_cols){
+  return arma::mat(const_cast<double*>(m.colptr(first_col)), m.n_rows, n_cols,
+                   false, true);
+}
+
+} // namespace fdpot
+
+#endif
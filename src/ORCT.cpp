@@ -1,4 +1,8 @@
 #include "ORCT.h"
+#include "MemoryViews.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
 namespace fdpot{
 
 template<>
@@ -6,14 +10,18 @@ double ORCT::cdf<double>(const double x) const {
   return 1 / (1 + std::exp(-x * this->gamma));
 }
 
+template<>
+float ORCT::cdf<float>(const float x) const {
+  return 1.f / (1.f + std::exp(-x * static_cast<float>(this->gamma)));
+}
+
 void ORCT::create_structure(void){
   // map for the left parent and right parent nodes
   // bijection for variables 
   this->structure.resize(this->n_nodes);
   
-#ifndef MYNDEBUG
-  std::cout << "Structure size is: " << structure.size() << std::endl;
-#endif 
+  Trace::event(Trace::Level::DEBUG, "orct.structure", "depth", depth, "n_nodes",
+               structure.size(), "n_feats", n_feats);
   
   //  structure.push_back(std::make_pair(std::vector<unsi))
   structure[0] = std::make_pair(std::vector<unsigned>(), std::vector<unsigned>());  
@@ -35,13 +43,8 @@ void ORCT::create_structure(void){
       structure[node] = std::make_pair(left_nodes, right_nodes);
       // since we went to the left, j is a left parent node, so update first
       structure[node].first.push_back(j);
-      #ifndef MYNDEBUG 
-	      std::cout << "Node " << node  << std::endl;
-	      for (const auto v: structure[node].first)
-		std::cout << "left parent value "  << v << std::endl;
-	      for (const auto v: structure[node].second)
-		std::cout << "right parent value "  << v << std::endl;
-      #endif
+      Trace::event(Trace::Level::VERBOSE, "orct.node", "node", node, "parent", j,
+                   "left_parents", structure[node].first.size());
       node++;
       
 
@@ -51,13 +54,8 @@ void ORCT::create_structure(void){
       structure[node] = std::make_pair(std::move(left_nodes), std::move(right_nodes));
       // we went to the right, update second
       structure[node].second.push_back(j);
-      #ifndef MYNDEBUG 
-		std::cout << "Node " << node  << std::endl;
-		for (const auto v: structure[node].first)
-		std::cout << "left parent value "  << v << std::endl;
-		for (const auto v: structure[node].second)
-		std::cout << "right parent value "  << v << std::endl;
-      #endif
+      Trace::event(Trace::Level::VERBOSE, "orct.node", "node", node, "parent", j,
+                   "left_parents", structure[node].first.size());
       node++;
       
       // Now we update the var_map: for each node tau maps the index of its first
@@ -80,24 +78,35 @@ void ORCT::create_structure(void){
 };
 
 
-Rcpp::List ORCT::predict(const arma::mat& feats, 
-                         const arma::vec& vars) const{
-  arma::mat probs_mat(feats.n_rows, this->n_labels);
-  arma::vec labels_vec(feats.n_rows);
+template<typename MatT, typename VarVecT>
+MatT ORCT::predict_probs(const MatT& feats, const VarVecT& vars) const{
+  MatT probs_mat(feats.n_rows, this->n_labels);
+  this->predict_probs_into(feats, vars, probs_mat);
+  return probs_mat;
+}
+
+template<typename MatT, typename VarVecT, typename OutMatT>
+void ORCT::predict_probs_into(const MatT& feats, const VarVecT& vars,
+                              OutMatT& probs_mat) const{
+  using VarT = typename VarVecT::value_type;
+  std::vector<VarT> leaf_probas(this->n_leaf_nodes);
+  // sample-major: the features of each unit are contiguous (see FeatT)
+  const MatT feats_t = feats.t();
   
   for (unsigned i = 0; i < feats.n_rows; i++){  // for each new statistical unit
+    // the leaf probabilities do not depend on the label
+    this->proba_fall_leaves<VarVecT>(feats_t.colptr(i), vars, leaf_probas.data());
     
     for(unsigned k = 0; k < this->n_labels; k++){  // for each label
       
-      double prob_k = 0.;  // initialise the probability of kth label
+      VarT prob_k = 0.;  // initialise the probability of kth label
       // now iterate are leaves
-      for (unsigned leaf = this->n_int_nodes;  // the 
-                    leaf < this->n_nodes; leaf++){
+      for (unsigned t = 0; t < this->n_leaf_nodes; t++){
         // first_class var in this leaf index
-        unsigned c_kt = this->var_map(leaf) + k;
+        unsigned c_kt = this->var_map(this->n_int_nodes + t) + k;
         // add the probability of falling on current leaf times \
         // probability kth class is chosen
-        prob_k += this->proba_fall_leaf(feats.row(i), vars, leaf) * vars[c_kt];
+        prob_k += leaf_probas[t] * vars[c_kt];
       }
       
       probs_mat(i, k) = prob_k;
@@ -109,12 +118,95 @@ Rcpp::List ORCT::predict(const arma::mat& feats,
         assert( std::abs(arma::sum( probs_mat.row(i) ) - 1) < EPS);
     #endif
     
-    unsigned best_label = probs_mat.row(i).index_max();
-    labels_vec(i) = best_label;
-    
   } // end for i
-  return Rcpp::List::create(_("predicted_labels_probs") = probs_mat,
-                            _("predicted_labels") = labels_vec);
+}
+
+// the two precisions used by the predict methods
+template arma::mat ORCT::predict_probs<arma::mat, arma::vec>(
+    const arma::mat&, const arma::vec&) const;
+template arma::fmat ORCT::predict_probs<arma::fmat, arma::fvec>(
+    const arma::fmat&, const arma::fvec&) const;
+template arma::mat ORCT::predict_probs<arma::mat, ORCT::SparseSplits>(
+    const arma::mat&, const ORCT::SparseSplits&) const;
+
+template<typename MatT, typename VarVecT>
+Rcpp::List ORCT::predict_list(const MatT& feats, const VarVecT& vars) const{
+  Rcpp::NumericMatrix probs(feats.n_rows, this->n_labels);
+  Rcpp::NumericVector labels(feats.n_rows);
+  arma::mat probs_mat = mat_view(probs);
+  this->predict_probs_into(feats, vars, probs_mat);
+  
+  for (unsigned i = 0; i < feats.n_rows; i++)
+    labels[i] = probs_mat.row(i).index_max();
+  
+  return Rcpp::List::create(_("predicted_labels_probs") = probs,
+                            _("predicted_labels") = labels);
+}
+
+Rcpp::List ORCT::predict(const arma::mat& feats, 
+                         const arma::vec& vars) const{
+  return this->predict_list(feats, vars);
   };
-}; // namespace fdpo
 
+Rcpp::List ORCT::predict(const arma::fmat& feats, 
+                         const arma::fvec& vars) const{
+  return this->predict_list(feats, vars);
+  };
+Rcpp::List ORCT::predict(const arma::mat& feats, 
+                         const SparseSplits& splits) const{
+  return this->predict_list(feats, splits);
+  };
+
+unsigned ORCT::prune_weights(arma::vec& vars, const double tol) const{
+  unsigned n_active = 0;
+  for (unsigned node = 0; node < this->n_int_nodes; node++){
+    unsigned first_idx = this->var_map(node);
+    // the last variable of the node is the intercept, never pruned
+    for (unsigned j = first_idx; j < first_idx + this->n_feats; j++){
+      if (std::abs(vars[j]) < tol)
+        vars[j] = 0.;
+      else
+        n_active++;
+    }
+  }
+  return n_active;
+};
+
+ORCT::SparseSplits ORCT::sparsify(const arma::vec& vars, const double tol) const{
+  SparseSplits splits;
+  splits.feat_idx.resize(this->n_int_nodes);
+  splits.weights.resize(this->n_int_nodes);
+  splits.vars = vars;
+  
+  for (unsigned node = 0; node < this->n_int_nodes; node++){
+    const unsigned first_idx = this->var_map(node);
+    arma::vec w = vars.subvec(first_idx, first_idx + this->n_feats - 1);
+    arma::uvec active = arma::find(arma::abs(w) >= tol);
+    
+    splits.weights[node] = w.elem(active);
+    splits.feat_idx[node] = std::move(active);
+  }
+  return splits;
+};
+
+arma::vec ORCT::grow_variables(const arma::vec& vars, const double pass_proba) const{
+  const ORCT deeper(this->depth + 1, this->n_feats, this->n_labels, this->gamma);
+  arma::vec grown(deeper.n_vars, arma::fill::zeros);
+  // the interior nodes have the same indices and variables in both trees
+  const unsigned n_split_vars = this->n_int_nodes * (this->n_feats + 1);
+  if (n_split_vars > 0)
+    grown.head(n_split_vars) = vars.head(n_split_vars);
+  // with null weights the argument of the cdf is -mu: cdf(-mu) = pass_proba,
+  // within the bounds of the intercepts
+  const double mu = std::max(-1., -std::log(pass_proba / (1. - pass_proba)) / this->gamma);
+  for (unsigned t = 0; t < this->n_leaf_nodes; t++){
+    const unsigned tau = this->n_int_nodes + t;  // a leaf here, interior there
+    grown(deeper.var_map(tau) + this->n_feats) = mu;
+    const arma::vec classes = vars.subvec(this->var_map(tau),
+                                          this->var_map(tau) + this->n_labels - 1);
+    for (const unsigned child: {2 * tau + 1, 2 * tau + 2})
+      grown.subvec(deeper.var_map(child), arma::size(classes)) = classes;
+  }
+  return grown;
+}
+}; // namespace fdpo
@@ -6,6 +6,7 @@
 #include <iostream> 
 #include <vector>
 #include <assert.h>   
+#include <type_traits>
 
 #include "RcppArmadillo.h"
 #include "helpers.h"
@@ -29,8 +30,42 @@ struct ORCT{
    */
   using StructureT=std::vector< std::pair<std::vector<unsigned>, std::vector<unsigned>> >;
   using TreeInfoT=std::vector<double>;
+  /*! @brief The type of the features matching a vector of variables
+   * 
+   * Single precision variables (arma::fvec) read single precision features
+   * (see the float inference path of predict); every other variable type
+   * (double, ADdouble) reads the double precision features.
+   * The features of a statistical unit are passed as a pointer to its 
+   * n_feats contiguous values, i.e. a column of the sample-major
+   * (n_feats x n_samples) features matrix: the dot products of the splits
+   * read contiguous memory and no row subview is materialised.
+   */
+  template<typename VarVecT>
+  using FeatT = typename std::conditional<
+    std::is_same<typename VarVecT::value_type, float>::value, float, double>::type;
   
   
+  /*! @brief Sparse storage of the split weights
+   * 
+   * Used for prediction when the tree was fitted with an L1 penalty on the
+   * weights of the interior nodes: only the surviving weights are kept, so 
+   * every split costs as many products as its active features.
+   * The intercepts and the leaf variables are read from the dense vector.
+   */
+  struct SparseSplits{
+    using value_type = double;
+    /*! @brief indices of the active features of each interior node */
+    std::vector<arma::uvec> feat_idx;
+    /*! @brief weights of the active features of each interior node */
+    std::vector<arma::vec> weights;
+    /*! @brief the dense variables vector (intercepts and leaf variables) */
+    arma::vec vars;
+    
+    inline double operator[](const unsigned idx) const{
+      return vars[idx];
+    }
+  };
+  
   /*! @brief Constructor
    * 
    * Given the input parameter, calculates other specs of the tree, namely
@@ -124,13 +159,13 @@ struct ORCT{
    * enable_if could be used so that only these two types are used for template 
    * specialisation. For scalability it was not used.
    * 
-   * @param feats the vector of the features for the statistical unit
+   * @param feats the n_feats contiguous features of the statistical unit
    * @param vars the vector of all variables. Of
    * @param tau the node index (which node it is)
    * 
    */ 
   template<typename VarVecT> 
-  typename VarVecT::value_type proba_go_left(const arma::rowvec & feats, const VarVecT &vars,
+  typename VarVecT::value_type proba_go_left(const FeatT<VarVecT>* feats, const VarVecT &vars,
                          unsigned tau) const; 
     /*! @brief computes the probability a statistical falls on a given leaf
    * 
@@ -147,14 +182,29 @@ struct ORCT{
    * enable_if could be used so that only these two types are used for template 
    * specialisation. For scalability it was not used.
    * 
-   * @param feats the vector of the features for the statistical unit
+   * @param feats the n_feats contiguous features of the statistical unit
    * @param vars the vector of all variables. Of
    * @param tau the leaf node index
    * 
    */ 
   template<typename VarVecT>
-  typename VarVecT::value_type proba_fall_leaf(const arma::rowvec&feats, const VarVecT & vars,
+  typename VarVecT::value_type proba_fall_leaf(const FeatT<VarVecT>* feats, const VarVecT & vars,
                            unsigned tau) const;
+  /*! @brief computes the probabilities a statistical unit falls on each leaf
+   * 
+   * Same as calling proba_fall_leaf for every leaf, except that the 
+   * probability of going left of each interior node is computed only once 
+   * and shared by all the leaves below it.
+   * 
+   * @param feats the n_feats contiguous features of the statistical unit
+   * @param vars the vector of all variables
+   * @param leaf_probas where to write the n_leaf_nodes probabilities
+   * @param stride distance between two consecutive leaves in leaf_probas
+   */
+  template<typename VarVecT>
+  void proba_fall_leaves(const FeatT<VarVecT>* feats, const VarVecT& vars,
+                         typename VarVecT::value_type* leaf_probas,
+                         const unsigned stride = 1) const;
   /*! @brief predict the labels (both probability and actual value)
   
   @param feats the features computed from the sample
@@ -162,15 +212,91 @@ struct ORCT{
   @return an Rcpp list with probabilities of belonging to the labels and the labels with maximum probability
   */
   Rcpp::List predict(const arma::mat& coefs, const arma::vec& vars) const;
+  
+  /*! @brief single precision version of predict
+  
+  Features, split weights and leaf probabilities are all kept in float: 
+  it halves the memory traffic of large scoring jobs.
+  @param feats the (single precision) features computed from the sample
+  @param vars the fitted variables, cast to single precision
+  @return same list as the double precision predict
+  */
+  Rcpp::List predict(const arma::fmat& feats, const arma::fvec& vars) const;
+  
+  /*! @brief predict with the sparse split weights
+  @param feats the features computed from the sample
+  @param splits the sparse weights (see sparsify)
+  @return same list as the dense predict
+  */
+  Rcpp::List predict(const arma::mat& feats, const SparseSplits& splits) const;
+  
+  /*! @brief set to zero the weights of the interior nodes below a tolerance
+  
+  Intercepts and leaf variables are left untouched.
+  @param vars the variables vector, modified in place
+  @param tol weights whose absolute value is smaller than tol are set to 0
+  @return the number of weights that survived
+  */
+  unsigned prune_weights(arma::vec& vars, const double tol) const;
+  
+  /*! @brief build the sparse storage of the split weights
+  @param vars the variables vector
+  @param tol weights whose absolute value is smaller than tol are dropped
+  @return the SparseSplits
+  */
+  SparseSplits sparsify(const arma::vec& vars, const double tol) const;
+  
+  /*! @brief the variables of the tree one level deeper, with the same 
+  predictions
+  
+  The interior nodes keep their splits. Each leaf becomes an interior node
+  whose split sends (almost) every sample left, with null weights and the
+  intercept giving pass_proba, and both its children copy its class 
+  variables: whichever way a sample goes, its label probabilities are the 
+  ones of this tree, and all the constraints hold.
+  @param vars the variables of this tree
+  @param pass_proba the probability of going left of the new splits, below
+  1 so that the optimiser sees their gradient
+  @return the variables of the tree of depth + 1
+  */
+  arma::vec grow_variables(const arma::vec& vars, const double pass_proba = .99) const;
 
+  /*! @brief probabilities of belonging to each label
+  
+  Shared by both versions of predict
+  @tparam MatT the features matrix type (arma::mat or arma::fmat)
+  @tparam VarVecT the variables vector type (arma::vec or arma::fvec)
+  @return a n_samples x n_labels matrix of probabilities
+  */
+  template<typename MatT, typename VarVecT>
+  MatT predict_probs(const MatT& feats, const VarVecT& vars) const;
   
+private:
+  /*! @brief same as predict_probs, written in a matrix of the right size
+  (e.g. a view of an R matrix, see mat_view)
+  @tparam OutMatT arma::mat or arma::fmat, whatever the precision of the features
+  @param probs_mat the n_samples x n_labels output
+  */
+  template<typename MatT, typename VarVecT, typename OutMatT>
+  void predict_probs_into(const MatT& feats, const VarVecT& vars,
+                          OutMatT& probs_mat) const;
   
+  /*! @brief The list returned by predict, whose probabilities and labels
+  are written in place in the R objects
+  */
+  template<typename MatT, typename VarVecT>
+  Rcpp::List predict_list(const MatT& feats, const VarVecT& vars) const;
 };
 
 // clarify why I did not use constexpr template for exp.
+// the specialisations of the cdf are in ORCT.cpp (ADdouble's in FdPot.cpp)
+template<>
+double ORCT::cdf<double>(const double x) const;
+template<>
+float ORCT::cdf<float>(const float x) const;
 
 template<typename VarVecT>
-typename VarVecT::value_type ORCT::proba_go_left(const arma::rowvec & feats,  
+typename VarVecT::value_type ORCT::proba_go_left(const FeatT<VarVecT>* feats,  
                              const VarVecT & vars,unsigned tau) const{
   using VarT = typename VarVecT::value_type;
   VarT val = 0.;
@@ -182,19 +308,15 @@ typename VarVecT::value_type ORCT::proba_go_left(const arma::rowvec & feats,
     assert(tau < this->n_int_nodes);
     // assert the var index is within the indices for the 
     assert(var_idx < this->n_int_nodes * (this->n_feats + 1));
-    // assert N-elements matche sn_feats
-    assert(feats.n_elem == this->n_feats);
-    // std::cout << "feats.n_elem " << feats.n_elem << std::endl;
-    // std::cout << "N_feats  " << this->n_feats << std::endl;
     
   #endif
       
   
-  for (unsigned i = 0; i < feats.n_elem; i++){  // perform dot product
-    val += feats(i) * (vars[var_idx++]);  // cannot use iterators with pragma (dependent)
+  for (unsigned i = 0; i < this->n_feats; i++){  // perform dot product
+    val += feats[i] * (vars[var_idx++]);  // cannot use iterators with pragma (dependent)
   }
   // normalise by number of features
-  val /= feats.n_elem; 
+  val /= this->n_feats; 
   #ifndef MYNDEBUG
     assert(var_idx == this->var_map(tau) + this->n_feats);
   #endif
@@ -206,6 +328,30 @@ typename VarVecT::value_type ORCT::proba_go_left(const arma::rowvec & feats,
 }
 
 
+/*! @brief Probability of going left with the sparse weights
+
+Only the active features of node tau enter the dot product, which is still
+normalised by the total number of features as in the dense version.
+*/
+template<>
+inline double ORCT::proba_go_left<ORCT::SparseSplits>(
+    const FeatT<SparseSplits>* feats, const SparseSplits & splits,
+    unsigned tau) const{
+  
+  const arma::uvec& idx = splits.feat_idx[tau];
+  const arma::vec& w = splits.weights[tau];
+  double val = 0.;
+  
+  for (unsigned a = 0; a < idx.n_elem; a++)  // sparse dot product
+    val += feats[idx(a)] * w(a);
+  // normalise by number of features
+  val /= this->n_feats;
+  // subtract the mu variable (intercept)
+  val -= splits[this->var_map(tau) + this->n_feats];
+  
+  return cdf<double>(val);
+}
+
 /*! @brief Probability the SU falls on a leaf
 
 @tparam VarVecT the type of the variable vector, in this project either arma::vec or OptimTraits::ADvector
@@ -213,7 +359,7 @@ typename VarVecT::value_type ORCT::proba_go_left(const arma::rowvec & feats,
 
 */
 template<typename VarVecT>
-typename VarVecT::value_type ORCT::proba_fall_leaf(const arma::rowvec& feats,
+typename VarVecT::value_type ORCT::proba_fall_leaf(const FeatT<VarVecT>* feats,
                                           const VarVecT & vars,
                                           unsigned tau) const{
   using VarT = typename VarVecT::value_type;
@@ -238,6 +384,27 @@ typename VarVecT::value_type ORCT::proba_fall_leaf(const arma::rowvec& feats,
   
 }
 
+template<typename VarVecT>
+void ORCT::proba_fall_leaves(const FeatT<VarVecT>* feats, const VarVecT& vars,
+                             typename VarVecT::value_type* leaf_probas,
+                             const unsigned stride) const{
+  using VarT = typename VarVecT::value_type;
+  
+  std::vector<VarT> go_left(this->n_int_nodes);
+  for (unsigned tau = 0; tau < this->n_int_nodes; tau++)
+    go_left[tau] = proba_go_left<VarVecT>(feats, vars, tau);
+  
+  for (unsigned t = 0; t < this->n_leaf_nodes; t++){
+    auto& leaf = structure[this->n_int_nodes + t];
+    VarT proba = 1.;
+    for (auto l: leaf.first)  // parents of nodes that went left
+      proba *= go_left[l];
+    for (auto r: leaf.second) // parents that went right
+      proba *= (1 - go_left[r]);
+    leaf_probas[t * stride] = proba;
+  }
+}
+
 }  // namespace fdpot
 
 #endif // of the ORCT header file
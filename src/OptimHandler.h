@@ -3,9 +3,16 @@
 #include <cppad/ipopt/solve.hpp>
 #include <functional>
 #include <memory>
+#include <sstream>
 #include <vector>
 #include <stdexcept>
 
+#include "TapedNLP.h"
+#include "OrctNLP.h"
+#include "SolverConfig.h"
+#include "StochasticTrainer.h"
+#include "Trace.h"
+
 namespace fdpot{
 class FdPot;  // forward declaration
 
@@ -136,6 +143,102 @@ public:
   */
   CppAD::ipopt::solve_result<Dvector> solution;
   
+  /*! @brief the recorded objective and constraints
+  Recorded once per fit by record_tape and shared by the copies of this 
+  handler, i.e. by all the restarts.
+  */
+  std::shared_ptr<ADTape> tape = nullptr;
+  
+  /*! @brief which derivatives are given to Ipopt (see OptimBackend) */
+  OptimBackend backend = OptimBackend::CPPAD;
+  
+  /*! @brief the Ipopt options, adjusted to the backend by solve */
+  SolverConfig config;
+  
+  /*! @brief starting multipliers: if not empty, solve warm starts Ipopt
+  from them and from variables (e.g. the solution of a nearby problem)
+  */
+  Dvector zl0, zu0, lambda0;
+  
+  /*! @brief initial barrier parameter of a warm start */
+  double mu0 = 1e-6;
+  
+  /*! @brief iterations after which solve stops, negative for no limit
+  (see RestartRace)
+  */
+  int iter_budget = -1;
+  
+  /*! @brief iterations, infeasibility and barrier parameter of the last solve */
+  IterationLog iter_log;
+  
+  /*! @brief iterations and evaluations of all the solves of this handler */
+  SolveCounts counts;
+  
+  /*! @brief seed of the sampling of the STOCHASTIC backend */
+  std::uint32_t seed = 0u;
+  
+  /*! @brief the objective evaluated without tape by the NATIVE and 
+  STOCHASTIC backends
+  Shared by the copies of this handler, i.e. by all the restarts.
+  */
+  std::shared_ptr<const OrctObjective> objective = nullptr;
+  
+  /*! @brief buffers of the evaluations of objective by the NATIVE backend,
+  kept with the handler so that its solves reuse them
+  */
+  OrctObjective::Workspace objective_work;
+  
+  /*! @brief Prepares this handler for a new restart of the problem of model
+  
+  As the copy assignment, except that the buffers of this handler (the
+  variables, the bounds, the evaluation buffers) keep their memory when
+  their size does not change, and that the optimisation functions are only
+  copied if the solve may have to record them (neither a tape nor an
+  objective); i.e. a pool of handlers is recycled by the restarts (see
+  FdPot::optimise). The solution and the counts are cleared.
+  @param model the handler set up by FdPot (see set_math_program)
+  */
+  inline void reset_from(const OptimHandler& model){
+    this->n_vars = model.n_vars;
+    this->n_constraints = model.n_constraints;
+    if (model.tape == nullptr and model.objective == nullptr)
+      this->fg_eval = model.fg_eval;
+    else
+      this->fg_eval.opt_funs = nullptr;
+    this->variables = model.variables;
+    this->xl = model.xl;
+    this->xu = model.xu;
+    this->gl = model.gl;
+    this->gu = model.gu;
+    this->solution = model.solution;
+    this->tape = model.tape;
+    this->backend = model.backend;
+    this->config = model.config;
+    this->zl0 = model.zl0;
+    this->zu0 = model.zu0;
+    this->lambda0 = model.lambda0;
+    this->mu0 = model.mu0;
+    this->iter_budget = model.iter_budget;
+    this->iter_log = model.iter_log;
+    this->counts = model.counts;
+    this->seed = model.seed;
+    this->objective = model.objective;
+  }
+  
+  /*! @brief records the tape of the optimisation functions
+  
+  Must be called after set_math_program; the operations are recorded at
+  the current variables. The time it takes is stored in tape->record_seconds.
+  @param dynamic parameters of the optimisation functions that can change
+  after the recording (see ADTape::record)
+  */
+  inline void record_tape(const std::vector<ADdouble*>& dynamic = {}){
+    this->tape = std::make_shared<ADTape>();
+    this->tape->record(this->fg_eval, this->variables, this->n_constraints,
+                       this->config.effective(this->backend).exact_hessian(),
+                       dynamic);
+  }
+  
   /*! @brief internal adjustments given number of vars and constrs
    * 
    * Given the number of variables and of constraints, updates the members
@@ -169,36 +272,69 @@ public:
   }
   /*! @brief perform the optimisation
    
-   This method utilises the FG_eval class, aggregated in an unique pointer 
-   in this class
-   * @note options are left as the default ones in the CppAD example,
-   * except for the numeric tolerance
+   With the CPPAD backend the derivatives come from the tape (recorded here 
+   if record_tape was not called before), which is used by an Ipopt 
+   application through TapedNLP; with the NATIVE one from objective, 
+   through OrctNLP. The STOCHASTIC backend does not use Ipopt (see 
+   StochasticTrainer)
+   * @note the options come from config (see SolverConfig)
    */
   inline void solve(void){
+    Trace::Span span(Trace::Level::DEBUG, "optim.solve", "seed", this->seed,
+                     "warm", not this->lambda0.is_empty());
+    if (this->backend == OptimBackend::STOCHASTIC){
+      if (this->objective == nullptr)
+        throw std::runtime_error("Error: the stochastic backend has no objective");
+      StochasticTrainer trainer(*(this->objective), this->config.stochastic, this->seed);
+      const unsigned epochs = trainer.train(variables, xl, xu, solution);
+      this->counts.iterations += epochs;
+      span.set_result("epochs", epochs);
+      return;
+    }
     // solve the problem
-    std::string options;
-    // options += "Integer print_level  0\n";  // disable verbose
-    options += "String  sb           yes\n";
-    // maximum number of iterations
-    // options += "Integer max_iter     10\n";
-    // approximate accuracy in first order necessary conditions;
-    // see Mathematical Programming, Volume 106, Number 1,
-    // Pages 25-57, Equation (6)
-    options += "Numeric tol          1e-12\n";
-    // derivative testing
-    options += "String  derivative_test            second-order\n";
-    // maximum amount of random pertubation; e.g.,
-    // when evaluation finite diff
-    options += "Numeric point_perturbation_radius  0.\n";
-#ifndef MYNDEBUG
-    std::cout << "Variables: " << variables << std::endl;
-#endif
-#ifdef DEV
-    Rcpp::Rcout << "Variables: " << variables << std::endl;
-#endif
-        CppAD::ipopt::solve<Dvector, FG_eval>(options, variables, xl, 
-                                                      xu, gl, gu, 
-                                                      this->fg_eval, solution);
+    std::string options = this->config.effective(this->backend).ipopt_options();
+    if (this->backend == OptimBackend::NATIVE){
+      // the constraints are linear
+      options += "String  jac_c_constant         yes\n";
+      options += "String  jac_d_constant         yes\n";
+    }
+    const bool warm_start = not this->lambda0.is_empty();
+    if (warm_start){
+      // start close to the central path of the previous solution
+      options += "String  warm_start_init_point      yes\n";
+      options += "Numeric warm_start_bound_push      1e-9\n";
+      options += "Numeric warm_start_mult_bound_push 1e-9\n";
+      std::ostringstream mu_init;
+      mu_init.precision(17);
+      mu_init << "Numeric mu_init                    " << this->mu0 << "\n";
+      options += mu_init.str();
+    }
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> app = IpoptApplicationFactory();
+        if (not apply_ipopt_options(options, *app))
+          throw std::runtime_error("Error: an Ipopt option was not accepted");
+        if (app->Initialize() != Ipopt::Solve_Succeeded)
+          throw std::runtime_error("Error: Ipopt could not be initialised");
+        
+        BoundedNLP* problem = nullptr;
+        if (this->backend == OptimBackend::NATIVE){
+          if (this->objective == nullptr)
+            throw std::runtime_error("Error: the native backend has no objective");
+          problem = new OrctNLP(*(this->objective), this->objective->tree(), variables,
+                                xl, xu, gl, gu, solution, this->objective_work);
+        }
+        else{
+          if (this->tape == nullptr)
+            this->record_tape();
+          problem = new TapedNLP(*(this->tape), variables, xl, xu, gl, gu, solution);
+        }
+        if (warm_start)
+          problem->set_multipliers(this->zl0, this->zu0, this->lambda0);
+        this->iter_log = IterationLog();
+        problem->track_iterations(this->iter_log, this->iter_budget);
+        Ipopt::SmartPtr<Ipopt::TNLP> nlp = problem;
+        app->OptimizeTNLP(nlp);
+        this->counts += counts_of(*app);
+        span.set_result("status", static_cast<int>(solution.status));
         
         if (not (solution.status == CppAD::ipopt::solve_result<Dvector>::success)) {
         // Commented on purpose, even if it not converges solution may be useful for analysis
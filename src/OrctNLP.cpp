@@ -0,0 +1,82 @@
+#include "OrctNLP.h"
+#include <algorithm>
+
+namespace fdpot{
+
+bool OrctNLP::get_nlp_info(Index& n_, Index& m_, Index& nnz_jac_g,
+                           Index& nnz_h_lag, IndexStyleEnum& index_style){
+  n_ = this->n;
+  m_ = this->m;
+  // every leaf variable appears once in each of the two families of constraints
+  nnz_jac_g = 2 * this->orct.n_leaf_nodes * this->orct.n_labels;
+  nnz_h_lag = 0;
+  index_style = C_STYLE;
+  return true;
+}
+
+bool OrctNLP::eval_f(Index n_, const Number* x, bool new_x, Number& obj_value){
+  // Ipopt usually asks for the gradient first, which also computes f
+  if (new_x or not this->f_cur_valid){
+    this->f_cur = this->objective.value(x, this->work);
+    this->f_cur_valid = true;
+  }
+  obj_value = this->f_cur;
+  return true;
+}
+
+bool OrctNLP::eval_grad_f(Index n_, const Number* x, bool new_x, Number* grad_f){
+  this->f_cur = this->objective.gradient(x, grad_f, this->work);
+  this->f_cur_valid = true;
+  return true;
+}
+
+bool OrctNLP::eval_g(Index n_, const Number* x, bool new_x, Index m_, Number* g){
+  Index i = 0;  // constraint index
+  // single class prediction per leaf
+  for (unsigned leaf = this->orct.n_int_nodes; leaf < this->orct.n_nodes; leaf++){
+    const unsigned first_idx = this->orct.var_map(leaf);
+    g[i] = 0.;
+    for (unsigned k = 0; k < this->orct.n_labels; k++)
+      g[i] += x[first_idx + k];
+    i++;
+  }
+  // at least one leaf per class
+  for (unsigned k = 0; k < this->orct.n_labels; k++){
+    g[i] = 0.;
+    for (unsigned leaf = this->orct.n_int_nodes; leaf < this->orct.n_nodes; leaf++)
+      g[i] += x[this->orct.var_map(leaf) + k];
+    i++;
+  }
+  return true;
+}
+
+bool OrctNLP::eval_jac_g(Index n_, const Number* x, bool new_x, Index m_,
+                         Index nele_jac, Index* iRow, Index* jCol, Number* values){
+  if (values != nullptr){  // the constraints are linear
+    std::fill(values, values + nele_jac, 1.);
+    return true;
+  }
+  Index e = 0;  // entry index
+  for (unsigned t = 0; t < this->orct.n_leaf_nodes; t++){
+    const unsigned first_idx = this->orct.var_map(this->orct.n_int_nodes + t);
+    for (unsigned k = 0; k < this->orct.n_labels; k++){
+      iRow[e] = t;
+      jCol[e++] = first_idx + k;
+    }
+  }
+  for (unsigned k = 0; k < this->orct.n_labels; k++)
+    for (unsigned t = 0; t < this->orct.n_leaf_nodes; t++){
+      iRow[e] = this->orct.n_leaf_nodes + k;
+      jCol[e++] = this->orct.var_map(this->orct.n_int_nodes + t) + k;
+    }
+  return true;
+}
+
+bool OrctNLP::eval_h(Index n_, const Number* x, bool new_x, Number obj_factor,
+                     Index m_, const Number* lambda, bool new_lambda,
+                     Index nele_hess, Index* iRow, Index* jCol, Number* values){
+  // the Hessian is approximated by Ipopt
+  return false;
+}
+
+} // namespace fdpot
@@ -0,0 +1,63 @@
+#ifndef ORCT_NLP_HH
+#define ORCT_NLP_HH
+#include <vector>
+
+#include "BoundedNLP.h"
+#include "OrctObjective.h"
+
+namespace fdpot{
+
+/*! @brief Ipopt problem of the ORCT with hand-written derivatives
+
+ @description The objective and its gradient come from an OrctObjective,
+ while the constraints (one class per leaf, at least one leaf per class) are
+ linear in the leaf variables, hence their Jacobian is a constant made of
+ ones. No Hessian is provided: Ipopt must be run with the limited-memory
+ quasi-Newton approximation (see OptimHandler::solve).
+ */
+class OrctNLP: public BoundedNLP{
+public:
+  /*! @brief Constructor
+   @param objective_ the objective function (not owned)
+   @param orct_ the tree structure (not owned)
+   @param x0_ the starting point
+   @param xl_, xu_ bounds of the variables
+   @param gl_, gu_ bounds of the constraints
+   @param solution_ where to store the solution (not owned)
+   @param work_ the buffers of the evaluations of the objective (not owned)
+   */
+  OrctNLP(const OrctObjective& objective_, const ORCT& orct_, const Dvector& x0_,
+          const Dvector& xl_, const Dvector& xu_,
+          const Dvector& gl_, const Dvector& gu_,
+          CppAD::ipopt::solve_result<Dvector>& solution_,
+          OrctObjective::Workspace& work_):
+    BoundedNLP(x0_, xl_, xu_, gl_, gu_, solution_), objective(objective_),
+    orct(orct_), work(work_) {};
+
+  bool get_nlp_info(Index& n_, Index& m_, Index& nnz_jac_g, Index& nnz_h_lag,
+                    IndexStyleEnum& index_style) override;
+
+  bool eval_f(Index n_, const Number* x, bool new_x, Number& obj_value) override;
+
+  bool eval_grad_f(Index n_, const Number* x, bool new_x, Number* grad_f) override;
+
+  bool eval_g(Index n_, const Number* x, bool new_x, Index m_, Number* g) override;
+
+  bool eval_jac_g(Index n_, const Number* x, bool new_x, Index m_, Index nele_jac,
+                  Index* iRow, Index* jCol, Number* values) override;
+
+  bool eval_h(Index n_, const Number* x, bool new_x, Number obj_factor,
+              Index m_, const Number* lambda, bool new_lambda,
+              Index nele_hess, Index* iRow, Index* jCol, Number* values) override;
+
+private:
+  const OrctObjective& objective;
+  const ORCT& orct;
+  OrctObjective::Workspace& work;
+  bool f_cur_valid = false;  // whether f_cur is the objective at the last x
+  double f_cur = 0.;
+};
+
+} // namespace fdpot
+
+#endif
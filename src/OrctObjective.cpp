@@ -0,0 +1,307 @@
+#include "OrctObjective.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace fdpot{
+
+namespace {
+/*! @brief the samples of a block of the gradients
+ The gradient of each block is summed on its own and the blocks in their
+ order: the sums do not depend on the number of threads nor on their timing
+ */
+constexpr unsigned block_size = 64;
+
+inline unsigned n_blocks(const unsigned n){ return (n + block_size - 1) / block_size; }
+
+/*! @brief sums the columns of blocks into grad, in their order */
+inline void sum_blocks(const arma::mat& blocks, double* grad){
+  for (unsigned b = 0; b < blocks.n_cols; b++)
+    for (unsigned v = 0; v < blocks.n_rows; v++)
+      grad[v] += blocks(v, b);
+}
+} // anonymous namespace
+
+void OrctObjective::sample_probas(const double* x, const unsigned i,
+                                  double* s, double* p) const{
+  const unsigned n_feats = this->orct.n_feats;
+  const double* feats = this->features.colptr(i);
+  for (unsigned tau = 0; tau < this->orct.n_int_nodes; tau++){
+    const double* w = x + this->orct.var_map(tau);
+    double val = 0.;
+    for (unsigned j = 0; j < n_feats; j++)
+      val += feats[j] * w[j];
+    // normalise by number of features and subtract the intercept
+    s[tau] = this->orct.cdf<double>(val / n_feats - w[n_feats]);
+  }
+  for (unsigned t = 0; t < this->orct.n_leaf_nodes; t++){
+    const auto& leaf = this->orct.structure[this->orct.n_int_nodes + t];
+    double proba = 1.;
+    for (auto l: leaf.first)
+      proba *= s[l];
+    for (auto r: leaf.second)
+      proba *= 1. - s[r];
+    p[t] = proba;
+  }
+}
+
+void OrctObjective::leaf_probas(const double* x, arma::mat& P) const{
+  const unsigned n = this->features.n_cols;
+  P.set_size(this->orct.n_leaf_nodes, n);
+  #pragma omp parallel
+  {
+    std::vector<double> s(this->orct.n_int_nodes);
+    #pragma omp for schedule(static)
+    for (unsigned i = 0; i < n; i++)
+      this->sample_probas(x, i, s.data(), P.colptr(i));
+  }
+}
+
+double OrctObjective::cost(const arma::mat& P, const double* x) const{
+  // summed in the order of the samples, whatever the threads
+  std::vector<double> sample_cost(P.n_cols, 0.);
+  #pragma omp parallel for schedule(static)
+  for (unsigned i = 0; i < P.n_cols; i++)
+    for (unsigned t = 0; t < P.n_rows; t++)
+      sample_cost[i] += P(t, i) * this->leaf_cost(x, i, this->orct.n_int_nodes + t);
+  double e_cost = 0.;
+  for (auto c: sample_cost)
+    e_cost += c;
+  return e_cost / P.n_cols;
+}
+
+double OrctObjective::penalty(const arma::mat& P) const{
+  arma::mat DP;
+  return this->penalty(P, DP);
+}
+
+double OrctObjective::penalty(const arma::mat& P, arma::mat& DP) const{
+  // sum over the pairs i < j of P_ti P_tj D_ij, whatever the diagonal of D
+  DP = P * this->dissim;
+  double e_diss = arma::accu(P % DP) - arma::accu(arma::square(P) * this->dissim.diag());
+  return 0.5 * e_diss / this->orct.n_leaf_nodes;
+}
+
+double OrctObjective::l1(const double* x) const{
+  double l1 = 0.;
+  const double sqrt_eps = std::sqrt(this->l1_eps);
+  for (unsigned node = 0; node < this->orct.n_int_nodes; node++){
+    const unsigned first_idx = this->orct.var_map(node);
+    // the intercept (last variable of the node) is not penalised
+    for (unsigned j = first_idx; j < first_idx + this->orct.n_feats; j++)
+      l1 += std::sqrt(x[j] * x[j] + this->l1_eps) - sqrt_eps;
+  }
+  return l1;
+}
+
+double OrctObjective::value(const double* x, Workspace& work) const{
+  this->leaf_probas(x, work.P);
+  double obj = this->cost(work.P, x) + this->alpha * this->penalty(work.P, work.DP);
+  if (this->l1_lambda > 0.)
+    obj += this->l1_lambda * this->l1(x);
+  return obj;
+}
+
+void OrctObjective::backprop_sample(const double* x, const unsigned i,
+                                    const double* s, const double* p,
+                                    const double* G, const double cost_weight,
+                                    double* g, double* dS) const{
+  const unsigned n_feats = this->orct.n_feats, n_int = this->orct.n_int_nodes;
+  const unsigned y_i = static_cast<unsigned>(this->y(i));
+  // class variables: p_t * cost(y_i, k)
+  if (cost_weight != 0.)
+    for (unsigned t = 0; t < this->orct.n_leaf_nodes; t++){
+      const unsigned c_kt = this->orct.var_map(n_int + t);
+      for (unsigned k = 0; k < this->orct.n_labels; k++)
+        if (k != y_i)
+          g[c_kt + k] += p[t] * this->missclaf_cost * cost_weight;
+    }
+  // back to the probabilities of going left: p_t is the product of the
+  // factors of its ancestors, the derivative drops the ancestor's factor
+  std::fill(dS, dS + n_int, 0.);
+  for (unsigned t = 0; t < this->orct.n_leaf_nodes; t++){
+    const auto& leaf = this->orct.structure[n_int + t];
+    for (auto l: leaf.first){
+      double others = 1.;
+      for (auto a: leaf.first)
+        if (a != l) others *= s[a];
+      for (auto a: leaf.second)
+        others *= 1. - s[a];
+      dS[l] += G[t] * others;
+    }
+    for (auto r: leaf.second){
+      double others = 1.;
+      for (auto a: leaf.first)
+        others *= s[a];
+      for (auto a: leaf.second)
+        if (a != r) others *= 1. - s[a];
+      dS[r] -= G[t] * others;
+    }
+  }
+  // and to the split variables, s = cdf(gamma * z)
+  const double* feats = this->features.colptr(i);
+  for (unsigned tau = 0; tau < n_int; tau++){
+    const double dz = dS[tau] * this->orct.gamma * s[tau] * (1. - s[tau]);
+    const unsigned first_idx = this->orct.var_map(tau);
+    for (unsigned j = 0; j < n_feats; j++)
+      g[first_idx + j] += dz * feats[j] / n_feats;
+    g[first_idx + n_feats] -= dz;
+  }
+}
+
+double OrctObjective::l1_gradient(const double* x, double* grad) const{
+  double l1 = 0.;
+  const double sqrt_eps = std::sqrt(this->l1_eps);
+  for (unsigned node = 0; node < this->orct.n_int_nodes; node++){
+    const unsigned first_idx = this->orct.var_map(node);
+    for (unsigned j = first_idx; j < first_idx + this->orct.n_feats; j++){
+      const double abs_w = std::sqrt(x[j] * x[j] + this->l1_eps);
+      l1 += abs_w - sqrt_eps;
+      grad[j] += this->l1_lambda * x[j] / abs_w;
+    }
+  }
+  return this->l1_lambda * l1;
+}
+
+double OrctObjective::gradient(const double* x, double* grad, Workspace& work) const{
+  const unsigned n = this->features.n_cols, n_int = this->orct.n_int_nodes,
+    n_leaves = this->orct.n_leaf_nodes, n_vars = this->orct.n_vars;
+
+  arma::mat &S = work.S, &P = work.P, &DP = work.DP;
+  S.set_size(n_int, n);
+  P.set_size(n_leaves, n);
+  #pragma omp parallel for schedule(static)
+  for (unsigned i = 0; i < n; i++)
+    this->sample_probas(x, i, S.colptr(i), P.colptr(i));
+
+  // column i of DP is (D p_t)_i for all the leaves t
+  DP = P * this->dissim;
+  const double obj = this->cost(P, x) + this->alpha * 0.5 / n_leaves *
+    (arma::accu(P % DP) - arma::accu(arma::square(P) * this->dissim.diag()));
+  // the pairs (i, i) are not in the sum
+  DP -= P.each_row() % this->dissim.diag().t();
+
+  work.blocks.zeros(n_vars, n_blocks(n));
+  #pragma omp parallel
+  {
+    std::vector<double> G(n_leaves), dS(n_int);
+    #pragma omp for schedule(static)
+    for (unsigned b = 0; b < work.blocks.n_cols; b++)
+      for (unsigned i = b * block_size; i < std::min(n, (b + 1) * block_size); i++){
+        // derivative with respect to the probabilities of the leaves
+        for (unsigned t = 0; t < n_leaves; t++)
+          G[t] = this->leaf_cost(x, i, n_int + t) / n +
+            this->alpha / n_leaves * DP(t, i);
+        this->backprop_sample(x, i, S.colptr(i), P.colptr(i), G.data(), 1. / n,
+                              work.blocks.colptr(b), dS.data());
+      }
+  }
+  std::fill(grad, grad + n_vars, 0.);
+  sum_blocks(work.blocks, grad);
+
+  if (this->l1_lambda > 0.)
+    return obj + this->l1_gradient(x, grad);
+  return obj;
+}
+
+double OrctObjective::batch_gradient(const double* x, const arma::uvec& samples,
+                                     const arma::umat& pairs, const double pair_weight,
+                                     double* grad) const{
+  const unsigned n = this->features.n_cols, n_int = this->orct.n_int_nodes,
+    n_leaves = this->orct.n_leaf_nodes, n_vars = this->orct.n_vars;
+  
+  // the samples whose probabilities are needed, and their column
+  const arma::uvec used = arma::unique(arma::join_cols(samples,
+                                                       arma::vectorise(pairs)));
+  std::vector<unsigned> col(n);
+  for (unsigned u = 0; u < used.n_elem; u++)
+    col[used(u)] = u;
+  arma::mat S(n_int, used.n_elem), P(n_leaves, used.n_elem);
+  #pragma omp parallel for schedule(static)
+  for (unsigned u = 0; u < used.n_elem; u++)
+    this->sample_probas(x, used(u), S.colptr(u), P.colptr(u));
+  
+  // derivatives with respect to the leaf probabilities
+  arma::mat G(n_leaves, used.n_elem, arma::fill::zeros);
+  arma::vec cost_weight(used.n_elem, arma::fill::zeros);
+  double e_cost = 0., e_diss = 0.;
+  for (auto i: samples){
+    const unsigned u = col[i];
+    cost_weight(u) += 1. / samples.n_elem;
+    for (unsigned t = 0; t < n_leaves; t++){
+      const double c = this->leaf_cost(x, i, n_int + t) / samples.n_elem;
+      e_cost += P(t, u) * c;
+      G(t, u) += c;
+    }
+  }
+  const double w = this->alpha * pair_weight / n_leaves;
+  for (unsigned r = 0; r < pairs.n_rows; r++){
+    const unsigned ui = col[pairs(r, 0)], uj = col[pairs(r, 1)];
+    const double d_ij = this->dissim(pairs(r, 0), pairs(r, 1));
+    e_diss += d_ij * arma::dot(P.col(ui), P.col(uj));
+    G.col(ui) += w * d_ij * P.col(uj);
+    G.col(uj) += w * d_ij * P.col(ui);
+  }
+  
+  arma::mat blocks(n_vars, n_blocks(used.n_elem), arma::fill::zeros);
+  #pragma omp parallel
+  {
+    std::vector<double> dS(n_int);
+    #pragma omp for schedule(static)
+    for (unsigned b = 0; b < blocks.n_cols; b++){
+      const unsigned end = std::min<unsigned>(used.n_elem, (b + 1) * block_size);
+      for (unsigned u = b * block_size; u < end; u++)
+        this->backprop_sample(x, used(u), S.colptr(u), P.colptr(u), G.colptr(u),
+                              cost_weight(u), blocks.colptr(b), dS.data());
+    }
+  }
+  std::fill(grad, grad + n_vars, 0.);
+  sum_blocks(blocks, grad);
+  
+  double obj = e_cost + w * e_diss;
+  if (this->l1_lambda > 0.)
+    obj += this->l1_gradient(x, grad);
+  return obj;
+}
+
+double OrctObjective::subset_value(const double* x, const arma::uvec& samples) const{
+  const unsigned n = this->features.n_cols, m = samples.n_elem;
+  arma::mat P(this->orct.n_leaf_nodes, m);
+  #pragma omp parallel
+  {
+    std::vector<double> s(this->orct.n_int_nodes);
+    #pragma omp for schedule(static)
+    for (unsigned u = 0; u < m; u++)
+      this->sample_probas(x, samples(u), s.data(), P.colptr(u));
+  }
+  double e_cost = 0.;
+  for (unsigned u = 0; u < m; u++)
+    for (unsigned t = 0; t < P.n_rows; t++)
+      e_cost += P(t, u) * this->leaf_cost(x, samples(u), this->orct.n_int_nodes + t);
+  e_cost /= m;
+  
+  // pairs of the subset, rescaled to the number of pairs of the whole sample.
+  // The dissimilarities are read in place, no submatrix is copied, and the
+  // rows are summed in their order, whatever the threads
+  std::vector<double> row_diss(m, 0.);
+  #pragma omp parallel for schedule(static)
+  for (unsigned u = 0; u < m; u++)
+    for (unsigned v = u + 1; v < m; v++)
+      row_diss[u] += this->dissim(samples(u), samples(v)) * arma::dot(P.col(u), P.col(v));
+  double e_diss = 0.;
+  for (auto d: row_diss)
+    e_diss += d;
+  e_diss /= this->orct.n_leaf_nodes;
+  if (m > 1)
+    e_diss *= (static_cast<double>(n) * (n - 1)) / (static_cast<double>(m) * (m - 1));
+  
+  double obj = e_cost + this->alpha * e_diss;
+  if (this->l1_lambda > 0.)
+    obj += this->l1_lambda * this->l1(x);
+  return obj;
+}
+
+} // namespace fdpot
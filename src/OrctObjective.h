@@ -0,0 +1,192 @@
+#ifndef ORCT_OBJECTIVE_HH
+#define ORCT_OBJECTIVE_HH
+
+#include "RcppArmadillo.h"
+#include "ORCT.h"
+
+namespace fdpot{
+
+/*! @brief The penalised ORCT objective with closed form gradient
+
+ @description Evaluates the same objective FdPot::create_mathematical_model
+ builds for CppAD, i.e. the expected misclassification cost plus alpha times
+ the expected dissimilarity in the leaves (plus the smoothed L1 penalty on
+ the split weights, if any), without any tape.
+
+ The gradient is obtained with the chain rule through the node
+ probabilities: the derivative of the objective with respect to the
+ probability of sample i falling in leaf t is
+
+   G_it = cost(i, t) / n + alpha / n_leaves * (D p_t)_i
+
+ where p_t is the vector of the probabilities of all the samples of falling
+ in t, and each split probability s = cdf(gamma * z) has ds/dz = gamma s (1 - s).
+ The loops over the samples are parallelised with OpenMP.
+ */
+class OrctObjective{
+public:
+  /*! @brief Constructor
+   @param orct_ the tree structure (not owned)
+   @param features_ the n_feats x n_samples (sample-major) scaled features (not owned)
+   @param y_ the labels (not owned)
+   @param dissim_ the dissimilarity matrix (not owned)
+   @param alpha_ the weight of the penalty
+   @param missclaf_cost_ the misclassification cost
+   @param l1_lambda_ the weight of the L1 penalty on the split weights
+   @param l1_eps_ the smoothing of the absolute value
+   */
+  OrctObjective(const ORCT& orct_, const arma::mat& features_,
+                const arma::vec& y_, const arma::mat& dissim_,
+                const double alpha_, const double missclaf_cost_,
+                const double l1_lambda_ = 0., const double l1_eps_ = 1e-8):
+    orct(orct_), features(features_), y(y_), dissim(dissim_), alpha(alpha_),
+    missclaf_cost(missclaf_cost_), l1_lambda(l1_lambda_), l1_eps(l1_eps_){};
+
+  /*! @brief the buffers of the evaluations (split and leaf probabilities,
+   dissimilarities times the leaf probabilities)
+
+   The objective is shared by the concurrent restarts, hence the buffers are
+   kept by the caller, e.g. one per restart (see OptimHandler), and sized by
+   the first evaluation; the following ones reuse their memory.
+   */
+  struct Workspace{
+    arma::mat S, P, DP;
+    arma::mat blocks;  // the gradients of the blocks of samples, see gradient
+  };
+
+  /*! @brief the objective function
+   @param x the variables
+   @param work the buffers
+   @return its value
+   */
+  double value(const double* x, Workspace& work) const;
+
+  inline double value(const double* x) const{
+    Workspace work;
+    return this->value(x, work);
+  }
+
+  /*! @brief the objective function and its gradient
+   @param x the variables
+   @param grad where to write the gradient (n_vars elements)
+   @param work the buffers
+   @return the value of the objective
+   */
+  double gradient(const double* x, double* grad, Workspace& work) const;
+
+  inline double gradient(const double* x, double* grad) const{
+    Workspace work;
+    return this->gradient(x, grad, work);
+  }
+
+  /*! @brief mini-batch estimate of the objective and of its gradient
+   
+   The cost is averaged over samples, the penalty is summed over pairs and
+   multiplied by pair_weight (the number of pairs of the whole sample over
+   the number of pairs drawn gives an unbiased estimate).
+   @param x the variables
+   @param samples the samples of the cost term
+   @param pairs n_pairs x 2 matrix with the pairs (i, j), i != j, of the penalty
+   @param pair_weight the weight of each pair
+   @param grad where to write the gradient (n_vars elements)
+   @return the estimate of the objective
+   */
+  double batch_gradient(const double* x, const arma::uvec& samples,
+                        const arma::umat& pairs, const double pair_weight,
+                        double* grad) const;
+
+  /*! @brief the objective restricted to a subset of the samples
+   
+   Cost averaged over the subset, penalty over all the pairs of the subset
+   rescaled to the number of pairs of the whole sample: comparable with
+   value. Used to monitor the convergence on held-out samples.
+   @param x the variables
+   @param samples the subset
+   */
+  double subset_value(const double* x, const arma::uvec& samples) const;
+
+  /*! @brief probabilities of falling in the leaves
+   @param x the variables
+   @param P n_leaf_nodes x n_samples matrix, column i holds sample i's
+   probabilities (resized if needed)
+   */
+  void leaf_probas(const double* x, arma::mat& P) const;
+
+  /*! @brief the expected misclassification cost
+   @param P the leaf probabilities (see leaf_probas)
+   @param x the variables
+   */
+  double cost(const arma::mat& P, const double* x) const;
+
+  /*! @brief the expected dissimilarity in the leaves (before the alpha weight)
+   @param P the leaf probabilities (see leaf_probas)
+   */
+  double penalty(const arma::mat& P) const;
+
+  /*! @brief as above, with the buffer of the product of P and the
+   dissimilarities */
+  double penalty(const arma::mat& P, arma::mat& DP) const;
+
+  /*! @brief changes the weight of the penalty (e.g. along an alpha path) */
+  inline void set_alpha(const double alpha_){ this->alpha = alpha_; }
+
+  /*! @brief the number of samples */
+  inline unsigned n_samples(void) const{ return this->features.n_cols; }
+
+  /*! @brief the tree structure the objective refers to */
+  inline const ORCT& tree(void) const{ return this->orct; }
+
+  /*! @brief the smoothed L1 penalty of the split weights (before the
+   l1_lambda weight) */
+  double l1(const double* x) const;
+
+private:
+  const ORCT& orct;
+  const arma::mat& features;
+  const arma::vec& y;
+  const arma::mat& dissim;
+  double alpha;
+  const double missclaf_cost, l1_lambda, l1_eps;
+
+  /*! @brief split and leaf probabilities of one sample
+   @param x the variables
+   @param i the sample
+   @param s where to write the probabilities of going left (n_int_nodes)
+   @param p where to write the probabilities of the leaves (n_leaf_nodes)
+   */
+  void sample_probas(const double* x, const unsigned i, double* s, double* p) const;
+
+  /*! @brief expected misclassification cost of a sample if it falls in a leaf
+   i.e. the sum over the labels k of cost(y_i, k) * c_k,leaf
+   */
+  inline double leaf_cost(const double* x, const unsigned i, const unsigned leaf) const{
+    const unsigned first_idx = orct.var_map(leaf);
+    double sum_c = 0.;
+    for (unsigned k = 0; k < orct.n_labels; k++)
+      sum_c += x[first_idx + k];
+    return this->missclaf_cost * (sum_c - x[first_idx + static_cast<unsigned>(y(i))]);
+  }
+
+  /*! @brief adds the gradient of the weighted L1 penalty to grad
+   @return the weighted L1 penalty
+   */
+  double l1_gradient(const double* x, double* grad) const;
+
+  /*! @brief chain rule from the leaf probabilities of a sample to the variables
+   @param x the variables
+   @param i the sample
+   @param s, p its split and leaf probabilities (see sample_probas)
+   @param G derivative of the objective with respect to p
+   @param cost_weight weight of the sample in the cost term (for the
+   derivative with respect to the class variables)
+   @param g where the gradient is accumulated
+   @param dS work buffer of n_int_nodes elements
+   */
+  void backprop_sample(const double* x, const unsigned i, const double* s,
+                       const double* p, const double* G, const double cost_weight,
+                       double* g, double* dS) const;
+};
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,59 @@
+#include "ParallelAD.h"
+#include <cppad/cppad.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace fdpot{
+
+#ifdef _OPENMP
+namespace {
+// the functions CppAD's thread_alloc uses to identify the OpenMP threads
+bool in_parallel(void){
+  return omp_in_parallel() != 0;
+}
+size_t thread_number(void){
+  return omp_get_level() > 0 ? static_cast<size_t>(omp_get_ancestor_thread_num(1)) : 0;
+}
+} // anonymous namespace
+#endif
+
+void parallel_ad_setup(const unsigned n_threads){
+#ifdef _OPENMP
+  if (n_threads <= 1)
+    return;
+  CppAD::thread_alloc::parallel_setup(n_threads, in_parallel, thread_number);
+  CppAD::parallel_ad<double>();
+#endif
+}
+
+void parallel_ad_teardown(const unsigned n_threads){
+#ifdef _OPENMP
+  if (n_threads <= 1)
+    return;
+  for (unsigned t = 1; t < n_threads; t++)
+    CppAD::thread_alloc::free_available(t);
+  CppAD::thread_alloc::parallel_setup(1, nullptr, nullptr);
+#endif
+}
+
+namespace {
+unsigned n_holds = 0;  // the ADMemoryHold alive (in sequential mode), they can nest
+} // anonymous namespace
+
+ADMemoryHold::ADMemoryHold(void){
+  if (CppAD::thread_alloc::in_parallel())
+    return;
+  if (n_holds++ == 0)
+    CppAD::thread_alloc::hold_memory(true);
+  this->held = true;
+}
+
+ADMemoryHold::~ADMemoryHold(){
+  if (not this->held or --n_holds > 0)
+    return;
+  CppAD::thread_alloc::hold_memory(false);
+  CppAD::thread_alloc::free_available(0);
+}
+
+} // namespace fdpot
@@ -0,0 +1,49 @@
+#ifndef PARALLEL_AD_HH
+#define PARALLEL_AD_HH
+#include <cstddef>
+
+namespace fdpot{
+
+/*! @brief Prepares CppAD for AD operations in several OpenMP threads
+
+ Must be called in sequential mode, before the parallel region. The threads
+ are identified by their number in the outermost parallel region, so that
+ a nested region (e.g. the restarts of a fold of CrossValidation, which run
+ in a team of one thread) keeps the number of its parent.
+ Does nothing without OpenMP or with a single thread.
+ @param n_threads the number of threads of the outermost region
+ */
+void parallel_ad_setup(const unsigned n_threads);
+
+/*! @brief Back to sequential mode
+ Frees the memory CppAD holds for the other threads; must be called after
+ the parallel region, once the AD objects of the threads are destroyed.
+ @param n_threads the number given to parallel_ad_setup
+ */
+void parallel_ad_teardown(const unsigned n_threads);
+
+/*! @brief Keeps the memory CppAD frees for reuse, while it lives
+
+ In sequential mode CppAD's thread_alloc gives the memory back to the
+ system as soon as it is freed, hence every solve allocates again the
+ buffers of the sweeps on the tape. While an ADMemoryHold lives they stay
+ in the pool of the thread that freed them, to be reused by the next
+ restart; they are freed when it is destroyed. It must be created and
+ destroyed in sequential mode; in parallel mode (e.g. within a fold of
+ CrossValidation) it does nothing, since thread_alloc holds the memory
+ anyway.
+ */
+class ADMemoryHold{
+public:
+  ADMemoryHold(void);
+  ~ADMemoryHold();
+  ADMemoryHold(const ADMemoryHold&) = delete;
+  ADMemoryHold& operator=(const ADMemoryHold&) = delete;
+
+private:
+  bool held = false;  // whether it was created in sequential mode
+};
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,256 @@
+#include "ProcessPool.h"
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace fdpot{
+
+void ProcessPool::Message::put(const arma::vec& values){
+  this->put<std::uint64_t>(values.n_elem);
+  const char* first = reinterpret_cast<const char*>(values.memptr());
+  this->bytes.insert(this->bytes.end(), first, first + values.n_elem * sizeof(double));
+}
+
+void ProcessPool::Message::put(const std::string& text){
+  this->put<std::uint64_t>(text.size());
+  this->bytes.insert(this->bytes.end(), text.begin(), text.end());
+}
+
+void ProcessPool::Message::get(arma::vec& values){
+  std::uint64_t n = 0;
+  this->get(n);
+  values.set_size(n);
+  this->read(values.memptr(), n * sizeof(double));
+}
+
+void ProcessPool::Message::get(std::string& text){
+  std::uint64_t n = 0;
+  this->get(n);
+  text.resize(n);
+  this->read(&text[0], n);
+}
+
+void ProcessPool::Message::read(void* to, const std::size_t n){
+  if (this->pos + n > this->bytes.size())
+    throw std::runtime_error("Error: truncated message from a worker process");
+  std::memcpy(to, this->bytes.data() + this->pos, n);
+  this->pos += n;
+}
+
+#ifndef _WIN32
+
+namespace {
+// sent instead of a task: the worker leaves
+// the longest the parent waits for the workers before checking for an interrupt
+// how often the parent checks for an interrupt while waiting
+const int poll_milliseconds = 100;
+
+/*! @brief Sends n bytes, without SIGPIPE if the other end is closed
+ @return false if the other end is closed
+ */
+bool send_all(const int fd, const void* from, std::size_t n){
+  const char* p = static_cast<const char*>(from);
+  while (n > 0){
+    const ssize_t sent = send(fd, p, n, MSG_NOSIGNAL);
+    if (sent < 0 and errno == EINTR)
+      continue;
+    if (sent <= 0)
+      return false;
+    p += sent;
+    n -= sent;
+  }
+  return true;
+}
+
+/*! @brief Reads n bytes
+ @return false if the other end was closed first
+ */
+bool recv_all(const int fd, void* to, std::size_t n){
+  char* p = static_cast<char*>(to);
+  while (n > 0){
+    const ssize_t got = recv(fd, p, n, 0);
+    if (got < 0 and errno == EINTR)
+      continue;
+    if (got <= 0)
+      return false;
+    p += got;
+    n -= got;
+  }
+  return true;
+}
+
+/*! @brief The loop of a worker: runs the tasks it is sent until told to
+ leave, then exits without returning to R
+ */
+[[noreturn]] void worker_loop(const int fd, const ProcessPool::Work& work){
+  std::uint32_t task = no_task;
+  int code = 0;
+  try{
+    while (recv_all(fd, &task, sizeof(task)) and task != no_task){
+      ProcessPool::Message out;
+      work(task, out);
+      const std::uint64_t n = out.bytes.size();
+      if (not send_all(fd, &n, sizeof(n)) or not send_all(fd, out.bytes.data(), n))
+        break;
+    }
+  }
+  catch (...){  // the parent reports the task as lost
+    code = 1;
+  }
+  close(fd);
+  _exit(code);  // no atexit handlers: they belong to the R session
+}
+
+struct Worker{
+  pid_t pid = -1;
+  int fd = -1;
+  long task = -1;  // the task it is running, -1 if none
+};
+} // anonymous namespace
+
+bool ProcessPool::available(void){ return true; }
+
+void ProcessPool::run(const std::vector<unsigned>& tasks, const Work& work,
+                      const Receive& receive, const Lost& lost) const{
+  std::vector<Worker> workers;
+  const unsigned n_workers = std::min<std::size_t>(this->n_workers, tasks.size());
+  workers.reserve(n_workers);
+  for (unsigned w = 0; w < n_workers; w++){
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+      break;
+    const pid_t pid = fork();
+    if (pid == 0){
+      close(fds[0]);
+      for (const auto& other: workers)  // the channels of the other workers
+        close(other.fd);
+#ifdef _OPENMP
+      // the workers already share the cores: a worker running OpenMP code
+      // (the native objective) would oversubscribe them, and the pool of
+      // threads of the parent is not usable after the fork anyway
+      omp_set_num_threads(1);
+#endif
+      worker_loop(fds[1], work);
+    }
+    close(fds[1]);
+    if (pid < 0){
+      close(fds[0]);
+      break;
+    }
+    Worker worker;
+    worker.pid = pid;
+    worker.fd = fds[0];
+    workers.push_back(worker);
+  }
+
+  auto stop = [](Worker& worker, const bool kill_it){
+    if (worker.fd < 0)
+      return;
+    if (kill_it)
+      kill(worker.pid, SIGKILL);
+    else
+      send_all(worker.fd, &no_task, sizeof(no_task));
+    close(worker.fd);
+    worker.fd = -1;
+    while (waitpid(worker.pid, nullptr, 0) < 0 and errno == EINTR){}
+  };
+
+  std::size_t next = 0;  // the next task to send
+  // sends the next task, or tells the worker to leave
+  auto dispatch = [&](Worker& worker){
+    worker.task = -1;
+    while (next < tasks.size()){
+      const std::uint32_t task = tasks[next++];
+      if (send_all(worker.fd, &task, sizeof(task))){
+        worker.task = task;
+        return;
+      }
+      lost(task, "the worker process exited");
+      stop(worker, true);
+      return;
+    }
+    stop(worker, false);
+  };
+
+  try{
+    if (workers.empty())
+      Rcpp::stop("cannot start the worker processes");
+    for (auto& worker: workers)
+      dispatch(worker);
+
+    std::vector<pollfd> fds;
+    std::vector<Worker*> polled;
+    while (true){
+      // every time, not only when no worker answers: while they keep
+      // sending results the pool might never be idle. It throws, and the
+      // workers are then killed and reaped (see below)
+      Rcpp::checkUserInterrupt();
+      fds.clear();
+      polled.clear();
+      for (auto& worker: workers)
+        if (worker.task >= 0){
+          fds.push_back(pollfd{worker.fd, POLLIN, 0});
+          polled.push_back(&worker);
+        }
+      if (fds.empty())
+        break;
+      const int ready = poll(fds.data(), fds.size(), poll_milliseconds);
+      if (ready < 0 and errno != EINTR)
+        Rcpp::stop("cannot wait for the worker processes");
+      if (ready <= 0)
+        continue;
+      for (std::size_t i = 0; i < fds.size(); i++){
+        if (fds[i].revents == 0)
+          continue;
+        Worker& worker = *polled[i];
+        const unsigned task = worker.task;
+        Message in;
+        std::uint64_t n = 0;
+        if (recv_all(worker.fd, &n, sizeof(n))){
+          in.bytes.resize(n);
+          if (recv_all(worker.fd, in.bytes.data(), n)){
+            receive(task, in);
+            dispatch(worker);
+            continue;
+          }
+        }
+        lost(task, "the worker process exited");
+        worker.task = -1;
+        stop(worker, true);
+      }
+    }
+    // the tasks of the workers that died were given to the others, unless
+    // none is left
+    for (; next < tasks.size(); next++)
+      lost(tasks[next], "no worker process left");
+  }
+  catch (...){  // e.g. an interrupt: the workers are not needed any more
+    for (auto& worker: workers)
+      stop(worker, true);
+    throw;
+  }
+}
+
+#else
+
+bool ProcessPool::available(void){ return false; }
+
+void ProcessPool::run(const std::vector<unsigned>&, const Work&, const Receive&,
+                      const Lost&) const{
+  Rcpp::stop("worker processes are not supported on Windows");
+}
+
+#endif
+
+} // namespace fdpot
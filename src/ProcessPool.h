@@ -0,0 +1,97 @@
+#ifndef PROCESS_POOL_HH
+#define PROCESS_POOL_HH
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief Solves tasks (e.g. the restarts of a fit) in forked worker processes
+
+ @description An alternative to the OpenMP threads for the code that is not
+ safe to run concurrently in one process (CppAD's global state, R). The
+ workers are forked once the problem is set up: they see the features, the
+ dissimilarity matrix and the tape of the parent through copy-on-write
+ pages, read-only, without copying them. Each worker is connected to the
+ parent by a socket pair: the parent sends it the index of a task, the
+ worker runs it and streams back the serialised result (see Message), then
+ gets the next task, so that the tasks are balanced as with an OpenMP
+ dynamic schedule. The results are read back in the parent, in the order
+ they arrive.
+ A worker never calls the R API and leaves with _exit. Only POSIX systems
+ have fork: see available.
+ */
+class ProcessPool{
+public:
+  /*! @brief Serialised result of a task, sent by a worker to the parent */
+  class Message{
+  public:
+    template<typename T>
+    void put(const T& value){
+      static_assert(std::is_trivially_copyable<T>::value, "cannot be sent as bytes");
+      const char* first = reinterpret_cast<const char*>(&value);
+      this->bytes.insert(this->bytes.end(), first, first + sizeof(T));
+    }
+    void put(const arma::vec& values);
+    void put(const std::string& text);
+
+    /*! @brief Reads the objects in the order they were put
+     @note throws std::runtime_error if the message is too short
+     */
+    template<typename T>
+    void get(T& value){
+      static_assert(std::is_trivially_copyable<T>::value, "cannot be read as bytes");
+      this->read(&value, sizeof(T));
+    }
+    void get(arma::vec& values);
+    void get(std::string& text);
+
+    std::vector<char> bytes;
+
+  private:
+    std::size_t pos = 0;
+    void read(void* to, const std::size_t n);
+  };
+
+  /*! @brief Runs a task in a worker and writes its result */
+  using Work = std::function<void(const unsigned task, Message& out)>;
+  /*! @brief Reads the result of a task, in the parent */
+  using Receive = std::function<void(const unsigned task, Message& in)>;
+  /*! @brief Called in the parent for a task that gave no result (its worker
+   died), with the reason
+   */
+  using Lost = std::function<void(const unsigned task, const std::string& reason)>;
+
+  /*! @brief whether worker processes can be forked on this system */
+  static bool available(void);
+
+  /*! @brief Constructor
+   @param n_workers_ the number of worker processes
+   */
+  explicit ProcessPool(const unsigned n_workers_): n_workers(std::max(n_workers_, 1u)) {};
+
+  /*! @brief Runs the tasks in at most n_workers processes
+
+   Must be called from R's thread: the user can interrupt while the parent
+   waits for the results, then the workers are killed and
+   Rcpp::internal::InterruptedException is thrown.
+   @param tasks the indices of the tasks
+   @param work runs a task, in a worker; it must not throw nor call the R
+   API (a worker that throws dies, and its task is lost)
+   @param receive reads the result of each task, in the parent
+   @param lost called in the parent for the tasks without a result
+   */
+  void run(const std::vector<unsigned>& tasks, const Work& work, const Receive& receive,
+           const Lost& lost) const;
+
+private:
+  const unsigned n_workers;
+};
+
+} // namespace fdpot
+
+#endif
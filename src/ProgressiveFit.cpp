@@ -0,0 +1,80 @@
+#include "ProgressiveFit.h"
+#include <chrono>
+#include <cmath>
+
+#include "Trace.h"
+
+using Rcpp::_;
+
+namespace fdpot{
+
+Rcpp::List ProgressiveFit::run(const arma::vec& y, const arma::mat& X_coeff,
+                               const unsigned n_feats, const unsigned start_depth,
+                               const unsigned depth, const unsigned n_sols){
+  const auto run_start = std::chrono::steady_clock::now();
+
+  // once for all the levels
+  auto start = std::chrono::steady_clock::now();
+  // shared by the problems of all the levels
+  const auto dissim = std::make_shared<const arma::mat>(
+    this->fd_handler.compute_dissim_matrix(X_coeff));
+  std::chrono::duration<double> dissim_seconds = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  const arma::mat features = this->fd_handler.compute_features(X_coeff, n_feats);
+  std::chrono::duration<double> features_seconds = std::chrono::steady_clock::now() - start;
+
+  const unsigned n_levels = depth - start_depth + 1;
+  arma::uvec depths(n_levels), n_vars(n_levels), n_warm(n_levels, arma::fill::zeros);
+  arma::vec setup_seconds(n_levels), solve_seconds(n_levels), best_obj(n_levels);
+  std::unique_ptr<FdPot> tree;
+  FdPotResults results;
+  for (unsigned l = 0; l < n_levels; l++){
+    depths(l) = start_depth + l;
+    // the solutions of the previous level, grown by one level
+    FdPotResults grown;
+    if (tree != nullptr){
+      const ORCT& shallow = tree->tree();
+      const ORCT deeper(depths(l), n_feats, shallow.n_labels, shallow.gamma);
+      grown = FdPotResults(n_sols, deeper.n_vars);
+      grown.obj_func_vals.fill(arma::datum::nan);
+      for (unsigned m = 0; m < n_sols; m++)
+        if (std::isfinite(results.obj_func_vals(m))){
+          grown.all_variables.col(m) = shallow.grow_variables(results.all_variables.col(m));
+          grown.obj_func_vals(m) = 0.;
+          n_warm(l)++;
+        }
+    }
+    Trace::event(Trace::Level::INFO, "progressive.level", "depth", depths(l),
+                 "grown", n_warm(l));
+    start = std::chrono::steady_clock::now();
+    tree = this->make_tree(depths(l));
+    tree->setup_precomputed(y, arma::mat(features), dissim, n_sols);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    setup_seconds(l) = elapsed.count();
+    n_vars(l) = tree->tree().n_vars;
+
+    start = std::chrono::steady_clock::now();
+    results = tree->optimise(l > 0 ? &grown : nullptr);
+    elapsed = std::chrono::steady_clock::now() - start;
+    solve_seconds(l) = elapsed.count();
+    best_obj(l) = results.obj_func_vals.min();
+  }
+  std::chrono::duration<double> total_seconds = std::chrono::steady_clock::now() - run_start;
+
+  return Rcpp::List::create(
+    _("fit_results") = tree->results_list(results),
+    _("levels") = Rcpp::List::create(
+      _("depth") = depths,
+      _("n_vars") = n_vars,
+      _("n_warm") = n_warm,
+      _("best_obj") = best_obj,
+      _("setup_seconds") = setup_seconds,
+      _("solve_seconds") = solve_seconds
+    ),
+    _("dissim_seconds") = dissim_seconds.count(),
+    _("features_seconds") = features_seconds.count(),
+    _("total_seconds") = total_seconds.count()
+  );
+}
+
+} // namespace fdpot
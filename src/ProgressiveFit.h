@@ -0,0 +1,60 @@
+#ifndef PROGRESSIVE_FIT_HH
+#define PROGRESSIVE_FIT_HH
+#include <functional>
+#include <memory>
+
+#include "RcppArmadillo.h"
+#include "BasisObj.h"
+#include "FdPot.h"
+
+namespace fdpot{
+
+/*! @brief Fits a deep tree by growing it one level at a time
+
+ @description The number of variables doubles with each level of the tree,
+ and so does the cost of the restarts from random points. Here the tree of
+ depth start_depth is fitted first, as fit would; then the solutions of
+ each level are grown into starting points of the next one (see
+ ORCT::grow_variables: every leaf becomes a split that lets the samples
+ through, above two copies of itself), which starts with the predictions
+ of the shallower tree instead of from scratch. The restarts whose
+ shallower solution failed start as in fit.
+ The features and the dissimilarity matrix do not depend on the depth:
+ they are computed once and shared by the levels, while every level has
+ its own problem (and tape).
+ */
+class ProgressiveFit{
+public:
+  /*! @brief Creates the (not fitted) tree of a depth */
+  using TreeFactory = std::function<std::unique_ptr<FdPot>(const unsigned depth)>;
+
+  /*! @brief Constructor
+   @param fd_handler_ computes features and dissimilarities
+   @param make_tree_ creates the tree of each level
+   */
+  ProgressiveFit(FdHandler<BasisEnum::BSPLINE>&& fd_handler_, TreeFactory make_tree_):
+    fd_handler(std::move(fd_handler_)), make_tree(std::move(make_tree_)) {};
+
+  /*! @brief Fits the levels from start_depth to depth
+   @param y the labels
+   @param X_coeff the coefficients matrix of the smoothing
+   @param n_feats the number of features
+   @param start_depth the depth of the first tree
+   @param depth the depth of the last tree
+   @param n_sols the number of restarts of each level
+   @return the results of the deepest tree (fit_results, as returned by
+   FdPot::fit), and a summary of each level (depth, number of variables,
+   best objective, set up and solve time) with the time spent on features
+   and dissimilarities and the total time
+   */
+  Rcpp::List run(const arma::vec& y, const arma::mat& X_coeff, const unsigned n_feats,
+                 const unsigned start_depth, const unsigned depth, const unsigned n_sols);
+
+private:
+  FdHandler<BasisEnum::BSPLINE> fd_handler;
+  TreeFactory make_tree;
+};
+
+} // namespace fdpot
+
+#endif
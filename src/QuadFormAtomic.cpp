@@ -0,0 +1,129 @@
+#include "QuadFormAtomic.h"
+#include <algorithm>
+
+namespace fdpot{
+
+QuadFormAtomic::QuadFormAtomic(const std::string& name,
+                               std::shared_ptr<const arma::mat> dissim_):
+  CppAD::atomic_three<double>(name), dissim(std::move(dissim_)),
+  dissim_diag(this->dissim->diag()) {}
+
+arma::mat QuadFormAtomic::times(const arma::mat& X) const{
+  // the pairs (i, i) are not part of the penalty
+  arma::mat DX = (*this->dissim) * X;
+  DX -= X.each_col() % this->dissim_diag;
+  return DX;
+}
+
+arma::mat QuadFormAtomic::taylor_matrix(const vector<double>& taylor_x,
+                                        size_t order_up) const{
+  const size_t n = this->dissim->n_rows, q = order_up + 1;
+  arma::mat X(n, q);
+  for (size_t j = 0; j < n; j++)
+    for (size_t k = 0; k < q; k++)
+      X(j, k) = taylor_x[j * q + k];
+  return X;
+}
+
+bool QuadFormAtomic::for_type(const vector<double>& parameter_x,
+                              const vector<ad_type_enum>& type_x,
+                              vector<ad_type_enum>& type_y){
+  type_y[0] = CppAD::constant_enum;
+  for (size_t j = 0; j < type_x.size(); j++)
+    type_y[0] = std::max(type_y[0], type_x[j]);
+  return true;
+}
+
+bool QuadFormAtomic::rev_depend(const vector<double>& parameter_x,
+                                const vector<ad_type_enum>& type_x,
+                                vector<bool>& depend_x,
+                                const vector<bool>& depend_y){
+  for (size_t j = 0; j < depend_x.size(); j++)
+    depend_x[j] = depend_y[0];
+  return true;
+}
+
+bool QuadFormAtomic::forward(const vector<double>& parameter_x,
+                             const vector<ad_type_enum>& type_x,
+                             size_t need_y, size_t order_low, size_t order_up,
+                             const vector<double>& taylor_x,
+                             vector<double>& taylor_y){
+  if (taylor_x.size() != this->dissim->n_rows * (order_up + 1))
+    return false;
+  // x(t) = sum_k x_k t^k, hence y_k = 1/2 sum_{l <= k} x_l^T D x_{k-l}
+  const arma::mat X = this->taylor_matrix(taylor_x, order_up);
+  const arma::mat DX = this->times(X);
+  for (size_t k = order_low; k <= order_up; k++){
+    double y_k = 0.;
+    for (size_t l = 0; l <= k; l++)
+      y_k += arma::dot(X.col(l), DX.col(k - l));
+    taylor_y[k] = 0.5 * y_k;
+  }
+  return true;
+}
+
+bool QuadFormAtomic::reverse(const vector<double>& parameter_x,
+                             const vector<ad_type_enum>& type_x,
+                             size_t order_up,
+                             const vector<double>& taylor_x,
+                             const vector<double>& taylor_y,
+                             vector<double>& partial_x,
+                             const vector<double>& partial_y){
+  const size_t n = this->dissim->n_rows, q = order_up + 1;
+  if (taylor_x.size() != n * q)
+    return false;
+  // d y_k / d x_l = D x_{k-l} for l <= k (D is symmetric)
+  const arma::mat DX = this->times(this->taylor_matrix(taylor_x, order_up));
+  for (size_t j = 0; j < n; j++)
+    for (size_t l = 0; l < q; l++){
+      double px = 0.;
+      for (size_t k = l; k < q; k++)
+        px += partial_y[k] * DX(j, k - l);
+      partial_x[j * q + l] = px;
+    }
+  return true;
+}
+
+bool QuadFormAtomic::jac_sparsity(const vector<double>& parameter_x,
+                                  const vector<ad_type_enum>& type_x,
+                                  bool dependency,
+                                  const vector<bool>& select_x,
+                                  const vector<bool>& select_y,
+                                  CppAD::sparse_rc<vector<size_t>>& pattern_out){
+  // y depends on every p
+  const size_t n = select_x.size();
+  size_t nnz = 0;
+  if (select_y[0])
+    for (size_t j = 0; j < n; j++)
+      nnz += select_x[j];
+  pattern_out.resize(1, n, nnz);
+  size_t e = 0;
+  if (select_y[0])
+    for (size_t j = 0; j < n; j++)
+      if (select_x[j])
+        pattern_out.set(e++, 0, j);
+  return true;
+}
+
+bool QuadFormAtomic::hes_sparsity(const vector<double>& parameter_x,
+                                  const vector<ad_type_enum>& type_x,
+                                  const vector<bool>& select_x,
+                                  const vector<bool>& select_y,
+                                  CppAD::sparse_rc<vector<size_t>>& pattern_out){
+  // the Hessian is D
+  const size_t n = select_x.size();
+  std::vector<size_t> rows, cols;
+  if (select_y[0])
+    for (size_t j = 0; j < n; j++)
+      for (size_t i = 0; i < n; i++)
+        if (i != j and select_x[i] and select_x[j] and (*this->dissim)(i, j) != 0.){
+          rows.push_back(i);
+          cols.push_back(j);
+        }
+  pattern_out.resize(n, n, rows.size());
+  for (size_t e = 0; e < rows.size(); e++)
+    pattern_out.set(e, rows[e], cols[e]);
+  return true;
+}
+
+} // namespace fdpot
@@ -0,0 +1,87 @@
+#ifndef QUAD_FORM_ATOMIC_HH
+#define QUAD_FORM_ATOMIC_HH
+#include <cppad/cppad.hpp>
+#include <memory>
+#include <string>
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief CppAD atomic function for the quadratic form of the penalty
+
+ @description Computes y = 1/2 p^T D p, with D the dissimilarity matrix
+ with its diagonal set to zero, i.e. the sum over the pairs i < j of
+ p_i p_j D_ij. It is the expected dissimilarity of a leaf given the 
+ probabilities p of the samples of falling in it.
+ 
+ On the tape it is a single operation instead of O(n^2) scalar ones; its
+ derivatives are computed with matrix-vector products: the gradient is 
+ D p and the Hessian is D.
+ 
+ @note CppAD requires atomic functions to be constructed in sequential 
+ mode and to outlive every tape that uses them.
+ */
+class QuadFormAtomic: public CppAD::atomic_three<double>{
+public:
+  template<typename T>
+  using vector = CppAD::vector<T>;
+  using ad_type_enum = CppAD::ad_type_enum;
+  
+  /*! @brief Constructor
+   @param name the name CppAD uses in its error messages
+   @param dissim_ the (symmetric) dissimilarity matrix, shared with the
+   caller (not copied); its diagonal is ignored
+   */
+  QuadFormAtomic(const std::string& name, std::shared_ptr<const arma::mat> dissim_);
+  
+private:
+  std::shared_ptr<const arma::mat> dissim;
+  arma::vec dissim_diag;  // subtracted from the products with dissim
+  
+  /*! @brief the product of D (diagonal set to zero) and X */
+  arma::mat times(const arma::mat& X) const;
+  
+  bool for_type(const vector<double>& parameter_x,
+                const vector<ad_type_enum>& type_x,
+                vector<ad_type_enum>& type_y) override;
+  
+  bool rev_depend(const vector<double>& parameter_x,
+                  const vector<ad_type_enum>& type_x,
+                  vector<bool>& depend_x,
+                  const vector<bool>& depend_y) override;
+  
+  bool forward(const vector<double>& parameter_x,
+               const vector<ad_type_enum>& type_x,
+               size_t need_y, size_t order_low, size_t order_up,
+               const vector<double>& taylor_x,
+               vector<double>& taylor_y) override;
+  
+  bool reverse(const vector<double>& parameter_x,
+               const vector<ad_type_enum>& type_x,
+               size_t order_up,
+               const vector<double>& taylor_x,
+               const vector<double>& taylor_y,
+               vector<double>& partial_x,
+               const vector<double>& partial_y) override;
+  
+  bool jac_sparsity(const vector<double>& parameter_x,
+                    const vector<ad_type_enum>& type_x,
+                    bool dependency,
+                    const vector<bool>& select_x,
+                    const vector<bool>& select_y,
+                    CppAD::sparse_rc<vector<size_t>>& pattern_out) override;
+  
+  bool hes_sparsity(const vector<double>& parameter_x,
+                    const vector<ad_type_enum>& type_x,
+                    const vector<bool>& select_x,
+                    const vector<bool>& select_y,
+                    CppAD::sparse_rc<vector<size_t>>& pattern_out) override;
+  
+  /*! @brief the Taylor coefficients of x as a n x (order_up + 1) matrix */
+  arma::mat taylor_matrix(const vector<double>& taylor_x, size_t order_up) const;
+};
+
+} // namespace fdpot
+
+#endif
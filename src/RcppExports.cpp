@@ -12,8 +12,8 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // pFdorct_Rcpp
-Rcpp::List pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, const Rcpp::String& basis_type, int depth, double alpha, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed);
-RcppExport SEXP _FdPot_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP) {
+Rcpp::List pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, const Rcpp::String& basis_type, int depth, double alpha, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options, std::string checkpoint_file, double checkpoint_interval, unsigned n_processes);
+RcppExport SEXP _FdPot_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP, SEXP checkpoint_fileSEXP, SEXP checkpoint_intervalSEXP, SEXP n_processesSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -30,20 +30,330 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
     Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
     Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
-    rcpp_result_gen = Rcpp::wrap(pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, basis_type, depth, alpha, similarity_method, n_feats, n_solve, gamma, seed));
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< double >::type checkpoint_interval(checkpoint_intervalSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_processes(n_processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, basis_type, depth, alpha, similarity_method, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options, checkpoint_file, checkpoint_interval, n_processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pFdorct_path_Rcpp
+Rcpp::List pFdorct_path_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, const arma::vec& alphas, const Rcpp::String& basis_type, int depth, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options, unsigned n_processes);
+RcppExport SEXP _FdPot_pFdorct_path_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP alphasSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP, SEXP n_processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alphas(alphasSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type basis_type(basis_typeSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type similarity_method(similarity_methodSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_processes(n_processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(pFdorct_path_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, alphas, basis_type, depth, similarity_method, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options, n_processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// refit_pFdorct_Rcpp
+Rcpp::List refit_pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, unsigned n_new, const arma::mat& start_vars, int depth, double alpha, unsigned n_feats, unsigned n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options, std::string checkpoint_file, double checkpoint_interval, unsigned n_processes);
+RcppExport SEXP _FdPot_refit_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP n_newSEXP, SEXP start_varsSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP, SEXP checkpoint_fileSEXP, SEXP checkpoint_intervalSEXP, SEXP n_processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_new(n_newSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type start_vars(start_varsSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< double >::type checkpoint_interval(checkpoint_intervalSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_processes(n_processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(refit_pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, n_new, start_vars, depth, alpha, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options, checkpoint_file, checkpoint_interval, n_processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// checkpoint_data_Rcpp
+Rcpp::List checkpoint_data_Rcpp(std::string checkpoint_file, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, unsigned n_feats);
+RcppExport SEXP _FdPot_checkpoint_data_Rcpp(SEXP checkpoint_fileSEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP n_featsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    rcpp_result_gen = Rcpp::wrap(checkpoint_data_Rcpp(checkpoint_file, X_coeffs, X_argvals, X_basis_df, X_basis_degree, n_feats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fd_cache_info_Rcpp
+Rcpp::List fd_cache_info_Rcpp();
+RcppExport SEXP _FdPot_fd_cache_info_Rcpp() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(fd_cache_info_Rcpp());
+    return rcpp_result_gen;
+END_RCPP
+}
+// set_fd_cache_Rcpp
+Rcpp::List set_fd_cache_Rcpp(std::string dir, double max_mb);
+RcppExport SEXP _FdPot_set_fd_cache_Rcpp(SEXP dirSEXP, SEXP max_mbSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< double >::type max_mb(max_mbSEXP);
+    rcpp_result_gen = Rcpp::wrap(set_fd_cache_Rcpp(dir, max_mb));
+    return rcpp_result_gen;
+END_RCPP
+}
+// set_trace_Rcpp
+Rcpp::List set_trace_Rcpp(int level, std::string file, unsigned buffer_events);
+RcppExport SEXP _FdPot_set_trace_Rcpp(SEXP levelSEXP, SEXP fileSEXP, SEXP buffer_eventsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type level(levelSEXP);
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type buffer_events(buffer_eventsSEXP);
+    rcpp_result_gen = Rcpp::wrap(set_trace_Rcpp(level, file, buffer_events));
+    return rcpp_result_gen;
+END_RCPP
+}
+// flush_trace_Rcpp
+unsigned flush_trace_Rcpp();
+RcppExport SEXP _FdPot_flush_trace_Rcpp() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(flush_trace_Rcpp());
+    return rcpp_result_gen;
+END_RCPP
+}
+// trace_info_Rcpp
+Rcpp::List trace_info_Rcpp();
+RcppExport SEXP _FdPot_trace_info_Rcpp() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(trace_info_Rcpp());
+    return rcpp_result_gen;
+END_RCPP
+}
+// cv_pFdorct_Rcpp
+Rcpp::List cv_pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, unsigned n_folds, const Rcpp::IntegerVector& folds, unsigned n_fold_threads, const Rcpp::String& basis_type, int depth, double alpha, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options);
+RcppExport SEXP _FdPot_cv_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP n_foldsSEXP, SEXP foldsSEXP, SEXP n_fold_threadsSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_folds(n_foldsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type folds(foldsSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_fold_threads(n_fold_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type basis_type(basis_typeSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type similarity_method(similarity_methodSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(cv_pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, n_folds, folds, n_fold_threads, basis_type, depth, alpha, similarity_method, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options));
+    return rcpp_result_gen;
+END_RCPP
+}
+// grid_pFdorct_Rcpp
+Rcpp::List grid_pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, const Rcpp::IntegerVector& depths, const Rcpp::IntegerVector& n_feats, const arma::vec& alphas, unsigned n_grid_threads, bool warm_start, const Rcpp::String& basis_type, Rcpp::String similarity_method, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options);
+RcppExport SEXP _FdPot_grid_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP depthsSEXP, SEXP n_featsSEXP, SEXP alphasSEXP, SEXP n_grid_threadsSEXP, SEXP warm_startSEXP, SEXP basis_typeSEXP, SEXP similarity_methodSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type depths(depthsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alphas(alphasSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_grid_threads(n_grid_threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type warm_start(warm_startSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type basis_type(basis_typeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type similarity_method(similarity_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(grid_pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, depths, n_feats, alphas, n_grid_threads, warm_start, basis_type, similarity_method, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options));
+    return rcpp_result_gen;
+END_RCPP
+}
+// progressive_pFdorct_Rcpp
+Rcpp::List progressive_pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, const Rcpp::String& basis_type, int depth, int start_depth, double alpha, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options, unsigned n_processes);
+RcppExport SEXP _FdPot_progressive_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP start_depthSEXP, SEXP alphaSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP, SEXP n_processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type basis_type(basis_typeSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< int >::type start_depth(start_depthSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type similarity_method(similarity_methodSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_processes(n_processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(progressive_pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, basis_type, depth, start_depth, alpha, similarity_method, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options, n_processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// forest_pFdorct_Rcpp
+Rcpp::List forest_pFdorct_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, unsigned n_trees, unsigned tree_feats, unsigned n_forest_threads, const Rcpp::String& basis_type, int depth, double alpha, Rcpp::String similarity_method, unsigned n_feats, int n_solve, double gamma, long int seed, double l1_lambda, double sparsity_tol, unsigned n_threads, const Rcpp::String& backend, const Rcpp::List& solver_options);
+RcppExport SEXP _FdPot_forest_pFdorct_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP n_treesSEXP, SEXP tree_featsSEXP, SEXP n_forest_threadsSEXP, SEXP basis_typeSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP similarity_methodSEXP, SEXP n_featsSEXP, SEXP n_solveSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP sparsity_tolSEXP, SEXP n_threadsSEXP, SEXP backendSEXP, SEXP solver_optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_trees(n_treesSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type tree_feats(tree_featsSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_forest_threads(n_forest_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type basis_type(basis_typeSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type similarity_method(similarity_methodSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_solve(n_solveSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type sparsity_tol(sparsity_tolSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_threads(n_threadsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type solver_options(solver_optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(forest_pFdorct_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, n_trees, tree_feats, n_forest_threads, basis_type, depth, alpha, similarity_method, n_feats, n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads, backend, solver_options));
     return rcpp_result_gen;
 END_RCPP
 }
 // predict_FdPot_Rcpp
-Rcpp::List predict_FdPot_Rcpp(const Rcpp::List& fitted_tree, const arma::mat& X_coefs, const unsigned result_idx);
-RcppExport SEXP _FdPot_predict_FdPot_Rcpp(SEXP fitted_treeSEXP, SEXP X_coefsSEXP, SEXP result_idxSEXP) {
+Rcpp::List predict_FdPot_Rcpp(const Rcpp::List& fitted_tree, const arma::mat& X_coefs, const unsigned result_idx, const Rcpp::String& precision);
+RcppExport SEXP _FdPot_predict_FdPot_Rcpp(SEXP fitted_treeSEXP, SEXP X_coefsSEXP, SEXP result_idxSEXP, SEXP precisionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::List& >::type fitted_tree(fitted_treeSEXP);
     Rcpp::traits::input_parameter< const arma::mat& >::type X_coefs(X_coefsSEXP);
     Rcpp::traits::input_parameter< const unsigned >::type result_idx(result_idxSEXP);
-    rcpp_result_gen = Rcpp::wrap(predict_FdPot_Rcpp(fitted_tree, X_coefs, result_idx));
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(predict_FdPot_Rcpp(fitted_tree, X_coefs, result_idx, precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predict_forest_Rcpp
+Rcpp::List predict_forest_Rcpp(const Rcpp::List& fitted_forest, const arma::mat& X_coefs);
+RcppExport SEXP _FdPot_predict_forest_Rcpp(SEXP fitted_forestSEXP, SEXP X_coefsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type fitted_forest(fitted_forestSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coefs(X_coefsSEXP);
+    rcpp_result_gen = Rcpp::wrap(predict_forest_Rcpp(fitted_forest, X_coefs));
+    return rcpp_result_gen;
+END_RCPP
+}
+// compare_precision_FdPot_Rcpp
+Rcpp::List compare_precision_FdPot_Rcpp(const Rcpp::List& fitted_tree, const arma::mat& X_coefs, const unsigned result_idx);
+RcppExport SEXP _FdPot_compare_precision_FdPot_Rcpp(SEXP fitted_treeSEXP, SEXP X_coefsSEXP, SEXP result_idxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type fitted_tree(fitted_treeSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coefs(X_coefsSEXP);
+    Rcpp::traits::input_parameter< const unsigned >::type result_idx(result_idxSEXP);
+    rcpp_result_gen = Rcpp::wrap(compare_precision_FdPot_Rcpp(fitted_tree, X_coefs, result_idx));
+    return rcpp_result_gen;
+END_RCPP
+}
+// derivatives_FdPot_Rcpp
+Rcpp::List derivatives_FdPot_Rcpp(const arma::vec& y, const arma::mat& X_coeffs, const Rcpp::NumericVector& X_argvals, int X_basis_df, int X_basis_degree, int depth, double alpha, unsigned n_feats, double gamma, long int seed, double l1_lambda, const Rcpp::String& backend, unsigned n_points);
+RcppExport SEXP _FdPot_derivatives_FdPot_Rcpp(SEXP ySEXP, SEXP X_coeffsSEXP, SEXP X_argvalsSEXP, SEXP X_basis_dfSEXP, SEXP X_basis_degreeSEXP, SEXP depthSEXP, SEXP alphaSEXP, SEXP n_featsSEXP, SEXP gammaSEXP, SEXP seedSEXP, SEXP l1_lambdaSEXP, SEXP backendSEXP, SEXP n_pointsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X_coeffs(X_coeffsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type X_argvals(X_argvalsSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_df(X_basis_dfSEXP);
+    Rcpp::traits::input_parameter< int >::type X_basis_degree(X_basis_degreeSEXP);
+    Rcpp::traits::input_parameter< int >::type depth(depthSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_feats(n_featsSEXP);
+    Rcpp::traits::input_parameter< double >::type gamma(gammaSEXP);
+    Rcpp::traits::input_parameter< long int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type l1_lambda(l1_lambdaSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::String& >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< unsigned >::type n_points(n_pointsSEXP);
+    rcpp_result_gen = Rcpp::wrap(derivatives_FdPot_Rcpp(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree, depth, alpha, n_feats, gamma, seed, l1_lambda, backend, n_points));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -93,8 +403,23 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_FdPot_pFdorct_Rcpp", (DL_FUNC) &_FdPot_pFdorct_Rcpp, 13},
-    {"_FdPot_predict_FdPot_Rcpp", (DL_FUNC) &_FdPot_predict_FdPot_Rcpp, 3},
+    {"_FdPot_pFdorct_Rcpp", (DL_FUNC) &_FdPot_pFdorct_Rcpp, 21},
+    {"_FdPot_pFdorct_path_Rcpp", (DL_FUNC) &_FdPot_pFdorct_path_Rcpp, 19},
+    {"_FdPot_refit_pFdorct_Rcpp", (DL_FUNC) &_FdPot_refit_pFdorct_Rcpp, 21},
+    {"_FdPot_checkpoint_data_Rcpp", (DL_FUNC) &_FdPot_checkpoint_data_Rcpp, 6},
+    {"_FdPot_fd_cache_info_Rcpp", (DL_FUNC) &_FdPot_fd_cache_info_Rcpp, 0},
+    {"_FdPot_set_fd_cache_Rcpp", (DL_FUNC) &_FdPot_set_fd_cache_Rcpp, 2},
+    {"_FdPot_set_trace_Rcpp", (DL_FUNC) &_FdPot_set_trace_Rcpp, 3},
+    {"_FdPot_flush_trace_Rcpp", (DL_FUNC) &_FdPot_flush_trace_Rcpp, 0},
+    {"_FdPot_trace_info_Rcpp", (DL_FUNC) &_FdPot_trace_info_Rcpp, 0},
+    {"_FdPot_cv_pFdorct_Rcpp", (DL_FUNC) &_FdPot_cv_pFdorct_Rcpp, 21},
+    {"_FdPot_grid_pFdorct_Rcpp", (DL_FUNC) &_FdPot_grid_pFdorct_Rcpp, 20},
+    {"_FdPot_progressive_pFdorct_Rcpp", (DL_FUNC) &_FdPot_progressive_pFdorct_Rcpp, 20},
+    {"_FdPot_forest_pFdorct_Rcpp", (DL_FUNC) &_FdPot_forest_pFdorct_Rcpp, 21},
+    {"_FdPot_predict_FdPot_Rcpp", (DL_FUNC) &_FdPot_predict_FdPot_Rcpp, 4},
+    {"_FdPot_predict_forest_Rcpp", (DL_FUNC) &_FdPot_predict_forest_Rcpp, 2},
+    {"_FdPot_compare_precision_FdPot_Rcpp", (DL_FUNC) &_FdPot_compare_precision_FdPot_Rcpp, 3},
+    {"_FdPot_derivatives_FdPot_Rcpp", (DL_FUNC) &_FdPot_derivatives_FdPot_Rcpp, 13},
     {"_FdPot_compute_func_datum_integral", (DL_FUNC) &_FdPot_compute_func_datum_integral, 5},
     {"_FdPot_get_bspline_internal_knots", (DL_FUNC) &_FdPot_get_bspline_internal_knots, 5},
     {"_FdPot_test_case_compute_dissim_and_feats", (DL_FUNC) &_FdPot_test_case_compute_dissim_and_feats, 5},
@@ -8,6 +8,14 @@
 #include "RcppArmadillo.h"
 #include <splines2Armadillo.h>
 #include "FdPot.h"
+#include "Checkpoint.h"
+#include "CrossValidation.h"
+#include "FdCache.h"
+#include "Forest.h"
+#include "GridSearch.h"
+#include "ProgressiveFit.h"
+#include "Trace.h"
+#include "MemoryViews.h"
 #include "helpers.h"
 
   
@@ -18,6 +26,224 @@
 using Rcpp::_; //aka Named (used to create an Rcpp::List)
 using namespace fdpot;
 
+namespace {
+/*! @brief Reads the solver options given from R
+@param solver_options named list, the missing options keep their default
+@return the solver configuration
+*/
+SolverConfig solver_config_of(const Rcpp::List& solver_options){
+  SolverConfig config;
+  if (solver_options.size() == 0)
+    return config;
+  Rcpp::CharacterVector names = solver_options.names();
+  for (R_xlen_t o = 0; o < solver_options.size(); o++){
+    const std::string name = Rcpp::as<std::string>(names[o]);
+    if (name == "hessian_approximation")
+      config.hessian_approximation = Rcpp::as<std::string>(solver_options[o]);
+    else if (name == "tol")
+      config.tol = Rcpp::as<double>(solver_options[o]);
+    else if (name == "acceptable_tol")
+      config.acceptable_tol = Rcpp::as<double>(solver_options[o]);
+    else if (name == "max_iter")
+      config.max_iter = Rcpp::as<int>(solver_options[o]);
+    else if (name == "derivative_test")
+      config.derivative_test = Rcpp::as<std::string>(solver_options[o]);
+    else if (name == "linear_solver")
+      config.linear_solver = Rcpp::as<std::string>(solver_options[o]);
+    else if (name == "print_level")
+      config.print_level = Rcpp::as<int>(solver_options[o]);
+    // options of the stochastic backend
+    else if (name == "method")
+      config.stochastic.method = Rcpp::as<std::string>(solver_options[o]);
+    else if (name == "learning_rate")
+      config.stochastic.learning_rate = Rcpp::as<double>(solver_options[o]);
+    else if (name == "batch_size")
+      config.stochastic.batch_size = Rcpp::as<unsigned>(solver_options[o]);
+    else if (name == "pair_batch_size")
+      config.stochastic.pair_batch_size = Rcpp::as<unsigned>(solver_options[o]);
+    else if (name == "max_epochs")
+      config.stochastic.max_epochs = Rcpp::as<unsigned>(solver_options[o]);
+    else if (name == "holdout_fraction")
+      config.stochastic.holdout_fraction = Rcpp::as<double>(solver_options[o]);
+    else if (name == "patience")
+      config.stochastic.patience = Rcpp::as<unsigned>(solver_options[o]);
+    else if (name == "rel_tol")
+      config.stochastic.rel_tol = Rcpp::as<double>(solver_options[o]);
+    else if (name == "coverage_weight")
+      config.stochastic.coverage_weight = Rcpp::as<double>(solver_options[o]);
+    // race of the restarts
+    else if (name == "racing")
+      config.racing.enabled = Rcpp::as<bool>(solver_options[o]);
+    else if (name == "racing_initial_iter")
+      config.racing.initial_iter = Rcpp::as<int>(solver_options[o]);
+    else if (name == "racing_keep_fraction")
+      config.racing.keep_fraction = Rcpp::as<double>(solver_options[o]);
+    else if (name == "racing_growth")
+      config.racing.growth = Rcpp::as<double>(solver_options[o]);
+    else if (name == "racing_min_survivors")
+      config.racing.min_survivors = Rcpp::as<unsigned>(solver_options[o]);
+    else if (name == "racing_feasibility_tol")
+      config.racing.feasibility_tol = Rcpp::as<double>(solver_options[o]);
+    // starting points
+    else if (name == "init")
+      config.init = Rcpp::as<std::string>(solver_options[o]);
+    else
+      Rcpp::stop("unknown solver option: " + name);
+  }
+  if (config.hessian_approximation != "exact" and 
+      config.hessian_approximation != "limited-memory")
+    Rcpp::stop("hessian_approximation must be either \"exact\" or \"limited-memory\"");
+  if (config.derivative_test != "none" and config.derivative_test != "first-order" and
+      config.derivative_test != "second-order" and 
+      config.derivative_test != "only-second-order")
+    Rcpp::stop("unknown derivative_test: " + config.derivative_test);
+  if (config.tol <= 0. or config.acceptable_tol <= 0. or config.max_iter < 0)
+    Rcpp::stop("tol and acceptable_tol must be positive, max_iter non-negative");
+  if (config.stochastic.method != "adam" and config.stochastic.method != "sgd")
+    Rcpp::stop("method must be either \"adam\" or \"sgd\"");
+  if (config.stochastic.learning_rate <= 0. or config.stochastic.batch_size == 0 or
+      config.stochastic.holdout_fraction < 0. or config.stochastic.holdout_fraction >= 1.)
+    Rcpp::stop("learning_rate and batch_size must be positive, holdout_fraction in [0, 1)");
+  if (config.racing.initial_iter < 1 or config.racing.keep_fraction <= 0. or
+      config.racing.keep_fraction >= 1. or config.racing.growth <= 1. or
+      config.racing.min_survivors == 0)
+    Rcpp::stop("racing_initial_iter and racing_min_survivors must be positive, "
+               "racing_keep_fraction in (0, 1), racing_growth greater than 1");
+  if (config.init != "random" and config.init != "cart" and config.init != "mixed")
+    Rcpp::stop("init must be one of \"random\", \"cart\", \"mixed\"");
+  return config;
+}
+
+/*! @brief Reads the backend given from R
+@param backend "cppad", "native" or "stochastic"
+*/
+OptimBackend backend_of(const Rcpp::String& backend){
+  if (backend == "native")
+    return OptimBackend::NATIVE;
+  else if (backend == "stochastic")
+    return OptimBackend::STOCHASTIC;
+  else if (backend != "cppad")
+    Rcpp::stop("backend must be one of \"cppad\", \"native\", \"stochastic\"");
+  return OptimBackend::CPPAD;
+}
+} // anonymous namespace
+
+namespace {
+/*! @brief Wraps the fit results with what predict_FdPot_Rcpp needs to
+rebuild the tree (the list returned by pFdorct_Rcpp)
+*/
+Rcpp::List fitted_tree_list(const Rcpp::List& fit_results, const unsigned n_samples,
+                            const double alpha, const Rcpp::NumericVector& X_argvals,
+                            const int X_basis_df, const int X_basis_degree,
+                            const arma::vec& boundary_knots, const double gamma,
+                            const long int seed, const double l1_lambda,
+                            const double sparsity_tol, const Rcpp::String& backend){
+  return Rcpp::List::create(
+    _("fit_results") = fit_results,
+    _("n_samples") = n_samples,
+    _("alpha") = alpha,
+    _("X_argvals") = X_argvals,
+    _("X_basis_df") = X_basis_df,
+    _("X_basis_degree") = X_basis_degree,
+    _("boundary_knots") = boundary_knots,
+    _("gamma") = gamma,
+    _("seed") = seed,
+    _("l1_lambda") = l1_lambda,
+    _("sparsity_tol") = sparsity_tol,
+    _("backend") = backend
+  );
+}
+
+/*! @brief Builds the tree and fits it, for one alpha or for a path
+Shared by pFdorct_Rcpp and pFdorct_path_Rcpp, see them for the parameters.
+@param path whether to call FdPot::fit_path
+*/
+Rcpp::List fit_tree_or_path(const arma::vec & y, 
+                        const arma::mat&  X_coeffs,
+                        const Rcpp::NumericVector & X_argvals,
+                        int X_basis_df,
+                        int X_basis_degree,
+                        const Rcpp::String & basis_type,
+                        int depth,
+                        const arma::vec& alphas,
+                        Rcpp::String similarity_method,
+                        unsigned n_feats,
+                        int n_solve,
+                        double gamma,
+                        long int seed,
+                        double l1_lambda,
+                        double sparsity_tol,
+                        unsigned n_threads,
+                        const Rcpp::String& backend,
+                        const Rcpp::List& solver_options,
+                        const bool path,
+                        const std::string& checkpoint_file = "",
+                        double checkpoint_interval = 60.,
+                        unsigned n_processes = 0
+){
+   //1 Basis object
+  // obtain the boundary knots
+  arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  Trace::event(Trace::Level::DEBUG, "basis", "lower", boundary_knots(0),
+               "upper", boundary_knots(1), "df", X_basis_df);
+  // now construct the basis
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
+                                 boundary_knots);
+  // Report/PresentationRaccontare dynamic loading (storia)
+  
+  // Validate dimensions
+  if (y.size() != X_coeffs.n_cols){
+                 Rcpp::stop("Number of rows in the coefficients matrix must\
+                 conform to the number of labels");
+  }
+
+  unsigned n_samples = X_coeffs.n_cols;
+  unsigned n_labels = arma::vec(arma::unique(y)).n_rows ; 
+
+  // Validate depths:
+  if (not (depth > 0)){
+    Rcpp::stop("depth must be at least 1");
+  }
+  // recall cum_tree_sum counts the number of nodes WITHOUT including the current one
+  unsigned n_leaf_nodes = helpers::cum_tree_sum(depth+1) - \
+                          helpers::cum_tree_sum(depth);
+  Trace::event(Trace::Level::INFO, "fit", "n_samples", n_samples, "n_labels", n_labels,
+               "n_leaf_nodes", n_leaf_nodes);
+  if(n_leaf_nodes < n_labels){
+    Rcpp::stop("Number of leaf nodes must be >= the number of labels,\
+               increase the depth" );
+  }
+  
+      
+
+ 
+ // use the Communicator (like in the design pattern)
+ // FunFact I became fond of such DP in the last challenge for the PACS course   
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  FdPot tree = FdPot(std::move(basis), n_labels, n_samples, n_feats, depth, alphas(0),
+                    seed, gamma, l1_lambda, sparsity_tol, n_threads, backend_of(backend),
+                    solver_config_of(solver_options));
+  tree.set_checkpoint(checkpoint_file, checkpoint_interval);
+  tree.set_processes(n_processes);
+  
+  auto fitted_tree_of = [&](const Rcpp::List& fit_results, const double alpha){
+    return fitted_tree_list(fit_results, n_samples, alpha, X_argvals, X_basis_df,
+                            X_basis_degree, boundary_knots, gamma, seed, l1_lambda,
+                            sparsity_tol, backend);
+  };
+  
+  if (not path)
+    return fitted_tree_of(tree.fit(y, X_coeffs, n_solve), alphas(0));
+  
+  Rcpp::List fit_path = tree.fit_path(y, X_coeffs, alphas, n_solve);
+  Rcpp::List fitted_trees(alphas.n_elem);
+  for (unsigned a = 0; a < alphas.n_elem; a++)
+    fitted_trees[a] = fitted_tree_of(fit_path[a], alphas(a));
+  return fitted_trees;
+}
+} // anonymous namespace
+
 //' Build and fit an FD-classification penalised tree
 //' 
 //' @description instantiates and fits a Functional Data Penalised Optimial Randomised Decision Tree
@@ -35,6 +261,14 @@ using namespace fdpot;
 //' @param n_solve how many different trees to fit starting from different init points
 //' @param gamma the randomisation factor for the ORCT, best kept default
 //' @param seed random seed for reproducibility
+//' @param l1_lambda weight of the L1 penalty on the split weights of the interior nodes, 0 (default) for dense splits
+//' @param sparsity_tol if l1_lambda > 0, split weights smaller than this tolerance are set to zero after the fit and the prediction uses only the surviving ones
+//' @param n_threads how many restarts to solve concurrently (requires OpenMP); with a linear solver of Ipopt that is not thread-safe (e.g. mumps, the default; see solver_options) the restarts are solved one at a time. The results do not depend on it
+//' @param backend how Ipopt gets the derivatives: "cppad" (default) records the objective with CppAD and uses the exact Hessian, "native" uses the closed form gradient of the objective with a limited-memory Hessian approximation (no tape), "stochastic" trains with mini-batch Adam or SGD steps instead of Ipopt, for large samples
+//' @param solver_options named list of Ipopt options overriding the defaults: hessian_approximation ("limited-memory" by default, or "exact"), tol (1e-8), acceptable_tol (1e-6), max_iter (1000), derivative_test ("none"), linear_solver ("mumps"), print_level (0). For the stochastic backend: method ("adam" or "sgd"), learning_rate (0.01), batch_size (256), pair_batch_size (4096, pairs of the penalty per step), max_epochs (200), holdout_fraction (0.1), patience (10 epochs), rel_tol (1e-4), coverage_weight (10, penalty on the "one leaf per class" constraints). To race the restarts (successive halving, Ipopt backends only): racing (FALSE), racing_initial_iter (10 iterations in the first round), racing_keep_fraction (0.5 of the restarts kept after each round), racing_growth (2, factor of the budget), racing_min_survivors (2 restarts solved to convergence), racing_feasibility_tol (1e-6); the summary of the race, including the iterations it saved, is in fit_results$racing. The starting points: init ("random", or "cart" for greedy CART trees on bootstrap samples, or "mixed" to alternate them; the iterations of each restart are in fit_results$telemetry). The options actually used are stored in fit_results$solver_options
+//' @param checkpoint_file if not empty, the fit is checkpointed to this file (and to checkpoint_file.data, the features and dissimilarities): calling again with the same data and parameters resumes it, skipping the preprocessing and the restarts already solved. Delete the files to start from scratch
+//' @param checkpoint_interval minimum seconds between two checkpoints of the restarts (0: after every batch of restarts); a checkpoint is also written on interrupt and at the end
+//' @param n_processes if positive, the restarts are solved by this many worker processes forked from the R session, which share the features, the dissimilarities and the tape with it (not on Windows); n_threads is then ignored, and no thread-safe linear solver is needed. The results do not depend on it
 // [[Rcpp::export]]
 Rcpp::List pFdorct_Rcpp(const arma::vec & y, 
                         const arma::mat&  X_coeffs,
@@ -48,157 +282,674 @@ Rcpp::List pFdorct_Rcpp(const arma::vec & y,
                         unsigned n_feats = 10,
                         int n_solve = 20 ,
                         double gamma = 512.,
-                        long int seed = 41703192
+                        long int seed = 41703192,
+                        double l1_lambda = 0.,
+                        double sparsity_tol = 1e-4,
+                        unsigned n_threads = 1,
+                        const Rcpp::String& backend = "cppad",
+                        const Rcpp::List& solver_options = Rcpp::List::create(),
+                        std::string checkpoint_file = "",
+                        double checkpoint_interval = 60.,
+                        unsigned n_processes = 0
 ){
-   //1 Basis object
-   // Call template class with basis, params
-
-#ifdef DEV
-   Rcpp::Rcout << "DEV defined" << std::endl;
-#endif
- // Call template class with basis, params
-// #define MYNDEBUG
-#ifdef MYNDEBUG
-   Rcpp::Rcout << "MYNDEBUG defined" << std::endl;
-#else
-   Rcpp::Rcout << "MYNDEBUG not defined" << std::endl;
-#endif
-   
-#ifndef MYNDEBUG 
-  std::cout << "Obtaining basis object" << std::endl;
-  std::cout << "Boundaries: " << X_argvals[0] << " and "\
-    << X_argvals[X_argvals.size()-1] << std::endl;
-#endif
-  // obtain the boundary knots
-#ifdef DEV
-  Rcpp::Rcout << "Obtaining boundary knots" << std::endl;
-#endif
+  if (checkpoint_interval < 0.)
+    Rcpp::stop("checkpoint_interval must be non-negative");
+  return fit_tree_or_path(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree,
+                          basis_type, depth, arma::vec{alpha}, similarity_method, n_feats,
+                          n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads,
+                          backend, solver_options, false, checkpoint_file,
+                          checkpoint_interval, n_processes);
+}
+
+//' Fit an FD-classification penalised tree for a sequence of alphas
+//' 
+//' @description Same as pFdorct_Rcpp, for each value in alphas. The features, the dissimilarity matrix and the CppAD tape are computed once, and the restarts of each alpha are warm started (variables and Ipopt multipliers) from the solutions of the previous one: sort alphas so that consecutive values are close.
+//' @param alphas the values of alpha, the hyperparameter for the penalty in the objective function
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,basis_type,depth,similarity_method,n_feats,n_solve,gamma,seed,l1_lambda,sparsity_tol,n_threads,backend,solver_options,n_processes see pFdorct_Rcpp
+//' @return a list with one element per alpha, each with the same structure of the result of pFdorct_Rcpp
+// [[Rcpp::export]]
+Rcpp::List pFdorct_path_Rcpp(const arma::vec & y, 
+                        const arma::mat&  X_coeffs,
+                        const Rcpp::NumericVector & X_argvals,
+                        int X_basis_df,
+                        int X_basis_degree,
+                        const arma::vec& alphas,
+                        const Rcpp::String & basis_type = "BSpline",
+                        int depth = 2,
+                        Rcpp::String similarity_method = "d0.L2",
+                        unsigned n_feats = 10,
+                        int n_solve = 20 ,
+                        double gamma = 512.,
+                        long int seed = 41703192,
+                        double l1_lambda = 0.,
+                        double sparsity_tol = 1e-4,
+                        unsigned n_threads = 1,
+                        const Rcpp::String& backend = "cppad",
+                        const Rcpp::List& solver_options = Rcpp::List::create(),
+                        unsigned n_processes = 0
+){
+  if (alphas.n_elem == 0)
+    Rcpp::stop("alphas must not be empty");
+  return fit_tree_or_path(y, X_coeffs, X_argvals, X_basis_df, X_basis_degree,
+                          basis_type, depth, alphas, similarity_method, n_feats,
+                          n_solve, gamma, seed, l1_lambda, sparsity_tol, n_threads,
+                          backend, solver_options, true, "", 60., n_processes);
+}
+
+//' Refit an FD-classification penalised tree after new samples are appended
+//' 
+//' @description The daily update of a fit: the features and the dissimilarities of the previous samples are read from the data of checkpoint_file (written by pFdorct_Rcpp or by a previous refit with the same file), only the ones of the new samples are computed, with O(n_new * n) integrals instead of O(n^2), and the extended data are written back. The restarts are warm started from the previous solutions. Without the data of the previous samples, everything is computed.
+//' @param n_new how many samples, the last columns of X_coeffs, are new
+//' @param start_vars the solutions of the previous fit (its fit_results$all_variables), the starting points of the restarts
+//' @param n_solve the number of restarts, 0 for one per previous solution; the ones without a previous solution start as in pFdorct_Rcpp
+//' @param y,X_coeffs the labels and the coefficients of all the samples, the previous ones first
+//' @param X_argvals,X_basis_df,X_basis_degree,depth,alpha,n_feats,gamma,seed,l1_lambda,sparsity_tol,n_threads,backend,solver_options,checkpoint_file,checkpoint_interval,n_processes see pFdorct_Rcpp; the ones of the tree must be the ones of the previous fit
+//' @return a list with the same structure of the result of pFdorct_Rcpp
+// [[Rcpp::export]]
+Rcpp::List refit_pFdorct_Rcpp(const arma::vec & y, 
+                              const arma::mat&  X_coeffs,
+                              const Rcpp::NumericVector & X_argvals,
+                              int X_basis_df,
+                              int X_basis_degree,
+                              unsigned n_new,
+                              const arma::mat& start_vars,
+                              int depth = 2,
+                              double alpha = .1,
+                              unsigned n_feats = 10,
+                              unsigned n_solve = 0,
+                              double gamma = 512.,
+                              long int seed = 41703192,
+                              double l1_lambda = 0.,
+                              double sparsity_tol = 1e-4,
+                              unsigned n_threads = 1,
+                              const Rcpp::String& backend = "cppad",
+                              const Rcpp::List& solver_options = Rcpp::List::create(),
+                              std::string checkpoint_file = "",
+                              double checkpoint_interval = 60.,
+                              unsigned n_processes = 0
+){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must conform to the number of labels");
+  if (depth < 1)
+    Rcpp::stop("depth must be at least 1");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  if (checkpoint_interval < 0.)
+    Rcpp::stop("checkpoint_interval must be non-negative");
+  const unsigned n_samples = X_coeffs.n_cols;
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  const arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree, boundary_knots);
+  FdPot tree = FdPot(std::move(basis), n_labels, n_samples, n_feats, depth, alpha,
+                     seed, gamma, l1_lambda, sparsity_tol, n_threads, backend_of(backend),
+                     solver_config_of(solver_options));
+  tree.set_checkpoint(checkpoint_file, checkpoint_interval);
+  tree.set_processes(n_processes);
+  const Rcpp::List fit_results = tree.refit(y, X_coeffs, n_new, start_vars,
+                                            n_solve > 0 ? n_solve : start_vars.n_cols);
+  return fitted_tree_list(fit_results, n_samples, alpha, X_argvals, X_basis_df,
+                          X_basis_degree, boundary_knots, gamma, seed, l1_lambda,
+                          sparsity_tol, backend);
+}
+
+//' Read the features and the dissimilarities checkpointed for some curves
+//' 
+//' @description Reads checkpoint_file.data, as written by pFdorct_Rcpp or refit_pFdorct_Rcpp with the same checkpoint_file, if it belongs to these curves and n_feats: e.g. to compare the data extended by a refit with the ones a fit computes from scratch.
+//' @param checkpoint_file the checkpoint file given to the fit
+//' @param X_coeffs,X_argvals,X_basis_df,X_basis_degree,n_feats see pFdorct_Rcpp
+//' @return a list with whether the data were found, the features (not scaled, n_samples x n_feats) and the dissimilarity matrix
+// [[Rcpp::export]]
+Rcpp::List checkpoint_data_Rcpp(std::string checkpoint_file,
+                                const arma::mat& X_coeffs,
+                                const Rcpp::NumericVector & X_argvals,
+                                int X_basis_df,
+                                int X_basis_degree,
+                                unsigned n_feats = 10){
+  const arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  FdHandler<BasisEnum::BSPLINE> fd_handler(
+    splines2::BSpline(X_argvals, X_basis_df, X_basis_degree, boundary_knots));
+  // the key of FdPot::data_key
+  const std::uint64_t key = fd_handler.cache_key(X_coeffs, "checkpoint.data", n_feats);
+  arma::mat features, dissim;
+  const bool found = Checkpoint(checkpoint_file).load_data(key, features, dissim);
+  return Rcpp::List::create(
+    _("found") = found,
+    _("features") = features,
+    _("dissim") = dissim
+  );
+}
+
+//' State of the cache of features and dissimilarity matrices
+//' 
+//' @return the directory, the size and the number of entries, the hits and misses since the cache was set (see set_fd_cache_Rcpp); an empty list if there is none
+// [[Rcpp::export]]
+Rcpp::List fd_cache_info_Rcpp(){
+  const auto& cache = FdCache::global();
+  return cache != nullptr ? cache->info() : Rcpp::List::create();
+}
+
+//' Cache features and dissimilarity matrices on disk
+//' 
+//' @description Once set, every fit, prediction, cross-validation, grid search and forest of the session looks the features and the dissimilarity matrices up in the directory before computing them, and stores the ones it computes. The entries are keyed by a hash of the coefficients, the basis, the quadrature, the similarity method and the number of features, so a dataset already seen skips the preprocessing whatever the other parameters. The least recently used entries are deleted when the cache is larger than max_mb.
+//' @param dir the directory of the cache, empty to stop caching (the files are kept)
+//' @param max_mb the maximum size of the cache, in megabytes
+//' @return see fd_cache_info_Rcpp
+// [[Rcpp::export]]
+Rcpp::List set_fd_cache_Rcpp(std::string dir = "", double max_mb = 1024.){
+  if (max_mb < 0.)
+    Rcpp::stop("max_mb must be non-negative");
+  auto& cache = FdCache::global();
+  if (dir.empty())
+    cache = nullptr;
+  else if (cache == nullptr or cache->dir != dir or cache->max_bytes != max_mb * 1048576.)
+    cache = std::make_shared<FdCache>(dir, max_mb * 1048576.);
+  return fd_cache_info_Rcpp();
+}
+
+//' Trace the fits
+//' 
+//' @description Sets which diagnostics the fits record. The events are kept in memory by the threads that record them and written out, in time order, at the end of each stage (after the set up of a problem, at the end of a fit, cross-validation, grid search or forest), or by flush_trace_Rcpp. Setting the trace first writes out the events of the previous one.
+//' @param level 0 (off), 1 (info: the stages of a fit), 2 (debug: each restart, node and feature), 3 (verbose: the innermost loops, e.g. each dissimilarity)
+//' @param file the file of the trace, truncated, in the Chrome trace event format (to open with chrome://tracing or https://ui.perfetto.dev); empty to print to the console
+//' @param buffer_events the events each thread keeps before dropping the oldest ones
+//' @return the level, the file, the buffer size, the threads which recorded events, and the events written and dropped
+// [[Rcpp::export]]
+Rcpp::List set_trace_Rcpp(int level = 0, std::string file = "", unsigned buffer_events = 16384){
+  if (level < 0 or level > 3)
+    Rcpp::stop("level must be 0 (off), 1 (info), 2 (debug) or 3 (verbose)");
+  if (buffer_events == 0)
+    Rcpp::stop("buffer_events must be positive");
+  Trace::flush();  // the events of the previous trace
+  Trace::configure(static_cast<Trace::Level>(level), file, buffer_events);
+  return Trace::info();
+}
+
+//' Write out the events traced so far
+//' 
+//' @return the number of events written
+// [[Rcpp::export]]
+unsigned flush_trace_Rcpp(){
+  return Trace::flush();
+}
+
+//' State of the trace
+//' 
+//' @return see set_trace_Rcpp
+// [[Rcpp::export]]
+Rcpp::List trace_info_Rcpp(){
+  return Trace::info();
+}
+
+//' Cross-validate an FD-classification penalised tree
+//' 
+//' @description k-fold cross-validation of pFdorct_Rcpp. The features and the dissimilarity matrix are computed once for the whole dataset and each fold takes its rows by index; the folds are fitted concurrently. The test samples of each fold are predicted with its best solution (their features are scaled on their own, as in predict_FdPot_Rcpp).
+//' @param n_folds the number of folds, ignored if folds is given
+//' @param folds the fold of each sample (from 0); if empty, the samples are assigned to n_folds folds at random, stratified by label
+//' @param n_fold_threads how many folds are fitted concurrently (requires OpenMP; one at a time with a linear solver of Ipopt that is not thread-safe, see n_threads); with more than one, the restarts of each fold are solved one after the other and n_threads is ignored
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,basis_type,depth,alpha,similarity_method,n_feats,n_solve,gamma,seed,l1_lambda,sparsity_tol,n_threads,backend,solver_options see pFdorct_Rcpp
+//' @return a list with the fold of each sample, the accuracy of each fold and their mean, the time spent on the shared features and dissimilarities and, for each fold, the time of set up, fit and prediction, the test samples (0-based), their predicted labels and the fit results (the chosen solution is best_variables)
+// [[Rcpp::export]]
+Rcpp::List cv_pFdorct_Rcpp(const arma::vec & y, 
+                           const arma::mat&  X_coeffs,
+                           const Rcpp::NumericVector & X_argvals,
+                           int X_basis_df,
+                           int X_basis_degree,
+                           unsigned n_folds = 5,
+                           const Rcpp::IntegerVector& folds = Rcpp::IntegerVector::create(),
+                           unsigned n_fold_threads = 1,
+                           const Rcpp::String & basis_type = "BSpline",
+                           int depth = 2,
+                           double alpha = .1,
+                           Rcpp::String similarity_method = "d0.L2",
+                           unsigned n_feats = 10,
+                           int n_solve = 20 ,
+                           double gamma = 512.,
+                           long int seed = 41703192,
+                           double l1_lambda = 0.,
+                           double sparsity_tol = 1e-4,
+                           unsigned n_threads = 1,
+                           const Rcpp::String& backend = "cppad",
+                           const Rcpp::List& solver_options = Rcpp::List::create()
+){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must\
+                 conform to the number of labels");
+  if (not (depth > 0))
+    Rcpp::stop("depth must be at least 1");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  if (helpers::n_leaf_nodes(depth) < n_labels)
+    Rcpp::stop("Number of leaf nodes must be >= the number of labels,\
+               increase the depth" );
+  if (folds.size() == 0 and (n_folds < 2 or n_folds > y.n_elem))
+    Rcpp::stop("n_folds must be between 2 and the number of samples");
+  
   arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
+                                 boundary_knots);
+  const OptimBackend optim_backend = backend_of(backend);
+  const SolverConfig solver_config = solver_config_of(solver_options);
+  // the basis of the trees is not used: the features are given to them
+  CrossValidation::TreeFactory make_tree = [&](const unsigned n_samples){
+    return std::make_unique<FdPot>(splines2::BSpline(basis), n_labels, n_samples,
+                                   n_feats, depth, alpha, seed, gamma, l1_lambda,
+                                   sparsity_tol, n_threads, optim_backend, solver_config);
+  };
+  CrossValidation cv(FdHandler<BasisEnum::BSPLINE>(splines2::BSpline(basis)), n_feats,
+                     make_tree, solver_config.solve_threads(n_fold_threads, optim_backend));
+  if (folds.size() > 0 and Rcpp::min(folds) < 0)
+    Rcpp::stop("folds must be non-negative");
+  const arma::uvec fold_of = folds.size() == 0 ? 
+    CrossValidation::stratified_folds(y, n_folds, seed) : Rcpp::as<arma::uvec>(folds);
+  return cv.run(y, X_coeffs, fold_of, n_solve);
+}
+
+//' Grid search over depth, n_feats and alpha for an FD-classification penalised tree
+//' 
+//' @description Fits pFdorct_Rcpp on every combination of depths, n_feats and alphas, computing each intermediate result once at the level it depends on: the dissimilarity matrix once, the features once per value of n_feats, the CppAD tape once per (depth, n_feats), while alpha is only a parameter of the tape. The alphas of a (depth, n_feats) pair are solved in the given order, and the pairs are fitted concurrently, the most expensive ones first.
+//' @param depths,n_feats,alphas the values of the grid
+//' @param n_grid_threads how many (depth, n_feats) pairs are fitted concurrently (requires OpenMP; one at a time with a linear solver of Ipopt that is not thread-safe, see n_threads); with more than one, the restarts of each fit are solved one after the other and n_threads is ignored
+//' @param warm_start whether each alpha is warm started from the solutions of the previous one of the same (depth, n_feats), as in pFdorct_path_Rcpp: sort alphas so that consecutive values are close
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,basis_type,similarity_method,n_solve,gamma,seed,l1_lambda,sparsity_tol,n_threads,backend,solver_options see pFdorct_Rcpp
+//' @return a list with the cells of the grid (depth, n_feats, alpha, the solve time, the error if the fit failed, and the fitted tree as returned by pFdorct_Rcpp), alpha varying fastest and depth slowest, and the time spent on the dissimilarities, on the features of each n_feats and on the set up of each tape
+// [[Rcpp::export]]
+Rcpp::List grid_pFdorct_Rcpp(const arma::vec & y, 
+                             const arma::mat&  X_coeffs,
+                             const Rcpp::NumericVector & X_argvals,
+                             int X_basis_df,
+                             int X_basis_degree,
+                             const Rcpp::IntegerVector& depths,
+                             const Rcpp::IntegerVector& n_feats,
+                             const arma::vec& alphas,
+                             unsigned n_grid_threads = 1,
+                             bool warm_start = true,
+                             const Rcpp::String & basis_type = "BSpline",
+                             Rcpp::String similarity_method = "d0.L2",
+                             int n_solve = 20 ,
+                             double gamma = 512.,
+                             long int seed = 41703192,
+                             double l1_lambda = 0.,
+                             double sparsity_tol = 1e-4,
+                             unsigned n_threads = 1,
+                             const Rcpp::String& backend = "cppad",
+                             const Rcpp::List& solver_options = Rcpp::List::create()
+){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must\
+                 conform to the number of labels");
+  if (depths.size() == 0 or n_feats.size() == 0 or alphas.n_elem == 0)
+    Rcpp::stop("depths, n_feats and alphas must not be empty");
+  if (Rcpp::min(depths) < 1 or Rcpp::min(n_feats) < 1)
+    Rcpp::stop("depths and n_feats must be at least 1");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  if (helpers::n_leaf_nodes(Rcpp::min(depths)) < n_labels)
+    Rcpp::stop("Number of leaf nodes must be >= the number of labels,\
+               increase the depth" );
   
-#ifndef MYNDEBUG
-  std::cout << "Printing boundary knots: \n" << boundary_knots << std::endl;
-#endif
-#ifdef DEV
-  Rcpp::Rcout << "Constructing basis" << std::endl;
-#endif
-  // now construct the basis
+  arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
   auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
                                  boundary_knots);
-  // Report/PresentationRaccontare dynamic loading (storia)
+  const unsigned n_samples = X_coeffs.n_cols;
+  const OptimBackend optim_backend = backend_of(backend);
+  const SolverConfig solver_config = solver_config_of(solver_options);
+  // the basis of the trees is not used: the features are given to them
+  GridSearch::TreeFactory make_tree = [&](const unsigned depth, const unsigned n_feats){
+    return std::make_unique<FdPot>(splines2::BSpline(basis), n_labels, n_samples,
+                                   n_feats, depth, alphas(0), seed, gamma, l1_lambda,
+                                   sparsity_tol, n_threads, optim_backend, solver_config);
+  };
+  GridSearch grid(FdHandler<BasisEnum::BSPLINE>(splines2::BSpline(basis)), make_tree,
+                  solver_config.solve_threads(n_grid_threads, optim_backend));
+  Rcpp::List search = grid.run(y, X_coeffs, Rcpp::as<arma::uvec>(depths),
+                               Rcpp::as<arma::uvec>(n_feats), alphas, n_solve, warm_start);
   
-  // Validate dimensions
-  if (y.size() != X_coeffs.n_cols){
-  #ifndef MYNDEBUG
-    std::cerr << "Error when working without MYNDEBUG" << std::endl;
-    std::cerr<<"Number of samples (cols in the coefficients matrix) must conform\
-                 the number of labels: provided " << y.size() << " labels"      \
-                                                  << " and " << X_coeffs.n_cols << " samples" << std::endl;
-               //   std::exit(1);
-                 
-                 Rcpp::stop("Number of rows in the coefficients matrix must\
-                 conform to the number of labels");
-  #else
-                 Rcpp::stop("Number of rows in the coefficients matrix must\
-                 conform to the number of labels");
-  #endif 
+  // each cell is a fitted tree, ready for predict_FdPot_Rcpp
+  Rcpp::List cells = search["cells"];
+  for (R_xlen_t c = 0; c < cells.size(); c++){
+    Rcpp::List cell = cells[c];
+    Rcpp::List fit_results = cell["fit_results"];
+    if (fit_results.size() > 0)
+      cell["fitted_tree"] = fitted_tree_list(fit_results, n_samples, cell["alpha"],
+                                             X_argvals, X_basis_df, X_basis_degree,
+                                             boundary_knots, gamma, seed, l1_lambda,
+                                             sparsity_tol, backend);
+    cells[c] = cell;
   }
+  search["cells"] = cells;
+  return search;
+}
 
-  unsigned n_samples = X_coeffs.n_cols;
-  unsigned n_labels = arma::vec(arma::unique(y)).n_rows ; 
+//' Fit an FD-classification penalised tree by growing it one level at a time
+//' 
+//' @description Fits the tree of depth start_depth as pFdorct_Rcpp, then each deeper tree up to depth starting from the solutions of the previous one: every leaf becomes a split that lets the samples through, whose children copy the class variables of the leaf, so that each level starts with the predictions of the previous one. The features and the dissimilarities are computed once. Cheaper than fitting a deep tree from random points, whose number of variables doubles with each level.
+//' @param depth the depth of the fitted tree
+//' @param start_depth the depth of the first tree, 0 for the shallowest one with as many leaves as labels
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,basis_type,alpha,similarity_method,n_feats,n_solve,gamma,seed,l1_lambda,sparsity_tol,n_threads,backend,solver_options,n_processes see pFdorct_Rcpp
+//' @return a list with the same structure of the result of pFdorct_Rcpp (the tree of depth depth) and progressive: for each level its depth, number of variables, restarts grown from the previous level, best objective, set up and solve seconds (levels), the seconds of the dissimilarities and of the features, and the total seconds
+// [[Rcpp::export]]
+Rcpp::List progressive_pFdorct_Rcpp(const arma::vec & y, 
+                                    const arma::mat&  X_coeffs,
+                                    const Rcpp::NumericVector & X_argvals,
+                                    int X_basis_df,
+                                    int X_basis_degree,
+                                    const Rcpp::String & basis_type = "BSpline",
+                                    int depth = 3,
+                                    int start_depth = 0,
+                                    double alpha = .1,
+                                    Rcpp::String similarity_method = "d0.L2",
+                                    unsigned n_feats = 10,
+                                    int n_solve = 20 ,
+                                    double gamma = 512.,
+                                    long int seed = 41703192,
+                                    double l1_lambda = 0.,
+                                    double sparsity_tol = 1e-4,
+                                    unsigned n_threads = 1,
+                                    const Rcpp::String& backend = "cppad",
+                                    const Rcpp::List& solver_options = Rcpp::List::create(),
+                                    unsigned n_processes = 0
+){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must conform to the number of labels");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  if (start_depth == 0)
+    while (helpers::n_leaf_nodes(++start_depth) < n_labels){}
+  if (start_depth < 1 or depth < start_depth)
+    Rcpp::stop("start_depth must be at least 1 and at most depth");
+  if (helpers::n_leaf_nodes(start_depth) < n_labels)
+    Rcpp::stop("Number of leaf nodes must be >= the number of labels,\
+               increase the start_depth" );
+  
+  arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
+                                 boundary_knots);
+  const unsigned n_samples = X_coeffs.n_cols;
+  const OptimBackend optim_backend = backend_of(backend);
+  const SolverConfig solver_config = solver_config_of(solver_options);
+  // the basis of the trees is not used: the features are given to them
+  ProgressiveFit::TreeFactory make_tree = [&](const unsigned level_depth){
+    auto tree = std::make_unique<FdPot>(splines2::BSpline(basis), n_labels, n_samples,
+                                        n_feats, level_depth, alpha, seed, gamma,
+                                        l1_lambda, sparsity_tol, n_threads,
+                                        optim_backend, solver_config);
+    tree->set_processes(n_processes);
+    return tree;
+  };
+  ProgressiveFit progressive(FdHandler<BasisEnum::BSPLINE>(splines2::BSpline(basis)),
+                             make_tree);
+  Rcpp::List fit = progressive.run(y, X_coeffs, n_feats, start_depth, depth, n_solve);
+  
+  Rcpp::List fitted_tree = fitted_tree_list(fit["fit_results"], n_samples, alpha,
+                                            X_argvals, X_basis_df, X_basis_degree,
+                                            boundary_knots, gamma, seed, l1_lambda,
+                                            sparsity_tol, backend);
+  fit.erase(fit.findName("fit_results"));  // already in fitted_tree
+  fitted_tree.push_back(fit, "progressive");
+  return fitted_tree;
+}
 
-  // Validate depths:
-  if (not (depth > 0)){
+namespace {
+/*! @brief Rebuild the functional data handler of a fitted tree
+@param fitted_tree the list returned by pFdorct_Rcpp
+@return the FdHandler, with the same basis used during the fit
+*/
+FdHandler<BasisEnum::BSPLINE> fd_handler_of(const Rcpp::List& fitted_tree){
+  // to obtain the features, need the basis
+  auto basis = splines2::BSpline(
+    Rcpp::as<Rcpp::NumericVector>(fitted_tree["X_argvals"]), 
+    Rcpp::as<int>(fitted_tree["X_basis_df"]), 
+    Rcpp::as<int>(fitted_tree["X_basis_degree"]),
+    Rcpp::as<arma::vec>(fitted_tree["boundary_knots"])
+  );
+  return FdHandler<BasisEnum::BSPLINE>(std::move(basis));
+}
+
+/*! @brief Rebuild the ORCT structure of a fitted tree
+@param fitted_tree the list returned by pFdorct_Rcpp
+*/
+ORCT orct_of(const Rcpp::List& fitted_tree){
+  Rcpp::List fit_results = Rcpp::as<Rcpp::List>(fitted_tree["fit_results"]);
+  Trace::event(Trace::Level::DEBUG, "orct_of", "depth", Rcpp::as<int>(fit_results["depth"]),
+               "n_feats", Rcpp::as<int>(fit_results["n_feats"]),
+               "n_labels", Rcpp::as<int>(fit_results["n_labels"]));
+  return ORCT(fit_results["depth"], fit_results["n_feats"], 
+              fit_results["n_labels"], fitted_tree["gamma"]);
+}
+} // anonymous namespace
+
+//' Fit a bagged forest of FD-classification penalised trees
+//' 
+//' @description Fits n_trees trees, each on a bootstrap sample of the data and on a random subset of tree_feats of the n_feats features. The features and the dissimilarity matrix are computed once and each tree takes the rows of its sample by index; the trees are fitted in waves of n_forest_threads concurrent trees, so that at most that many problems are in memory.
+//' @param n_trees the number of trees
+//' @param tree_feats how many of the n_feats features each tree uses (by default, all of them)
+//' @param n_forest_threads how many trees are fitted concurrently (requires OpenMP; one at a time with a linear solver of Ipopt that is not thread-safe, see n_threads); with more than one, the restarts of each tree are solved one after the other and n_threads is ignored
+//' @param n_solve the number of restarts of each tree
+//' @param seed the seed of the bootstrap samples, of the feature subsets and of the restarts; tree t uses seed + t
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,basis_type,depth,alpha,similarity_method,n_feats,gamma,l1_lambda,sparsity_tol,n_threads,backend,solver_options see pFdorct_Rcpp
+//' @return the fitted forest, a single list to be given to predict_forest_Rcpp (and saved, e.g. with saveRDS): forest_results holds the best variables of each tree, its features (0-based), its objective, its in-bag counts of the samples and the timings
+// [[Rcpp::export]]
+Rcpp::List forest_pFdorct_Rcpp(const arma::vec & y, 
+                               const arma::mat&  X_coeffs,
+                               const Rcpp::NumericVector & X_argvals,
+                               int X_basis_df,
+                               int X_basis_degree,
+                               unsigned n_trees = 50,
+                               unsigned tree_feats = 0,
+                               unsigned n_forest_threads = 1,
+                               const Rcpp::String & basis_type = "BSpline",
+                               int depth = 2,
+                               double alpha = .1,
+                               Rcpp::String similarity_method = "d0.L2",
+                               unsigned n_feats = 10,
+                               int n_solve = 5,
+                               double gamma = 512.,
+                               long int seed = 41703192,
+                               double l1_lambda = 0.,
+                               double sparsity_tol = 1e-4,
+                               unsigned n_threads = 1,
+                               const Rcpp::String& backend = "cppad",
+                               const Rcpp::List& solver_options = Rcpp::List::create()
+){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must\
+                 conform to the number of labels");
+  if (not (depth > 0))
     Rcpp::stop("depth must be at least 1");
-  }
-  // recall cum_tree_sum counts the number of nodes WITHOUT including the current one
-  unsigned n_leaf_nodes = helpers::cum_tree_sum(depth+1) - \
-                          helpers::cum_tree_sum(depth);
-#ifndef MYNDEBUG
-  std::cout << "number of leaf nodes: " << n_leaf_nodes << std::endl;
-  std::cout << "number of labels: " << n_labels << std::endl;
-#endif 
-#ifdef DEV
-  Rcpp::Rcout <<"number of leaf nodes: " << n_leaf_nodes << std::endl;
-  Rcpp::Rcout <<  "number of labels: " << n_labels << std::endl;
-#endif
-  if(n_leaf_nodes < n_labels){
-    #ifndef MYNDEBUG
-    std::cerr << "Number of leaf nodes must be >= the number of labels,\
-               increase the depth" << std::endl;
-    std::exit(1);
-    #else
+  if (n_trees == 0 or n_feats == 0 or tree_feats > n_feats)
+    Rcpp::stop("n_trees and n_feats must be positive, tree_feats at most n_feats");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  if (helpers::n_leaf_nodes(depth) < n_labels)
     Rcpp::stop("Number of leaf nodes must be >= the number of labels,\
                increase the depth" );
-    #endif
-  }
+  if (tree_feats == 0)
+    tree_feats = n_feats;
   
-      
-
- 
- // use the Communicator (like in the design pattern)
- // FunFact I became fond of such DP in the last challenge for the PACS course   
-  #ifdef DEV
-  Rcpp::Rcout << "Instantiating tree" << std::endl;
-  #endif 
-  FdPot tree = FdPot(std::move(basis), n_labels, n_samples, n_feats, depth, alpha,
-                    seed, gamma);
-  #ifdef DEV
-  Rcpp::Rcout << "Fitting tree" << std::endl;
-  #endif
-  
-  Rcpp::List fit_results = tree.fit(y, X_coeffs, n_solve);
-  Rcpp::List fitted_tree_specs = Rcpp::List::create(
-    _("fit_results") = fit_results,
-    _("n_samples") = n_samples,
+  arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
+                                 boundary_knots);
+  const OptimBackend optim_backend = backend_of(backend);
+  const SolverConfig solver_config = solver_config_of(solver_options);
+  // the basis of the trees is not used: the features are given to them
+  Forest::TreeFactory make_tree = [&](const unsigned n_samples, const unsigned n_feats,
+                                      const std::uint32_t tree_seed){
+    return std::make_unique<FdPot>(splines2::BSpline(basis), n_labels, n_samples,
+                                   n_feats, depth, alpha, tree_seed, gamma, l1_lambda,
+                                   sparsity_tol, n_threads, optim_backend, solver_config);
+  };
+  Forest forest(FdHandler<BasisEnum::BSPLINE>(splines2::BSpline(basis)), n_feats,
+                tree_feats, make_tree,
+                solver_config.solve_threads(n_forest_threads, optim_backend));
+  return Rcpp::List::create(
+    _("forest_results") = forest.fit(y, X_coeffs, n_trees, n_solve, seed),
+    _("n_samples") = X_coeffs.n_cols,
+    _("depth") = depth,
+    _("n_labels") = n_labels,
     _("alpha") = alpha,
     _("X_argvals") = X_argvals,
     _("X_basis_df") = X_basis_df,
     _("X_basis_degree") = X_basis_degree,
     _("boundary_knots") = boundary_knots,
     _("gamma") = gamma,
-    _("seed") = seed
+    _("seed") = seed,
+    _("backend") = backend
   );
-    
-  return fitted_tree_specs;
-  };
+}
 
+//' Predict the labels of new functional data with a fitted tree
+//' 
+//' @param fitted_tree the list returned by pFdorct_Rcpp
+//' @param X_coefs p x n matrix with the coefficients of the new functional data
+//' @param result_idx which of the fitted solutions to use (0-based)
+//' @param precision "double" (default) or "single": the latter computes features, split weights and leaf probabilities in float
 // [[Rcpp::export]]
 Rcpp::List predict_FdPot_Rcpp(const Rcpp::List& fitted_tree,
                         const arma::mat& X_coefs,
-                        const unsigned result_idx){
+                        const unsigned result_idx,
+                        const Rcpp::String& precision = "double"){
   Rcpp::List fit_results = Rcpp::as<Rcpp::List>(fitted_tree["fit_results"]);
-  // to obtain the features, need the basis
-  auto basis = splines2::BSpline(
-    Rcpp::as<Rcpp::NumericVector>(fitted_tree["X_argvals"]), 
-    Rcpp::as<int>(fitted_tree["X_basis_df"]), 
-    Rcpp::as<int>(fitted_tree["X_basis_degree"]),
-    Rcpp::as<arma::vec>(fitted_tree["boundary_knots"])
-  );
+  auto fd_handler = fd_handler_of(fitted_tree);
+  const unsigned n_feats = Rcpp::as<unsigned>(fit_results["n_feats"]);
   
-  FdHandler<BasisEnum::BSPLINE> fd_handler(std::move(basis));
-  auto feats = arma::mat( fd_handler.compute_features(X_coefs, 
-                                                      fit_results("n_labels"))
-                          );
-  arma::mat all_vars = Rcpp::as<arma::mat>(fit_results["all_variables"]);
-#ifdef DEV
-  Rcpp::Rcout << all_vars.n_rows << " and " << all_var.n_cols<< std::endl
-#endif
+  const Rcpp::NumericMatrix all_variables = fit_results["all_variables"];
+  const arma::mat all_vars = mat_view(all_variables);  // no copy
   arma::vec vars = all_vars.col(result_idx);
+  ORCT tree = orct_of(fitted_tree);
+  
+  if (precision == "single"){
+    arma::fmat feats = fd_handler.compute_features_single(X_coefs, n_feats);
+    FdPot::scale_features(feats);
+    return tree.predict(feats, arma::conv_to<arma::fvec>::from(vars));
+  }
+  else if (precision != "double")
+    Rcpp::stop("precision must be either \"double\" or \"single\"");
+  
+  auto feats = arma::mat( fd_handler.compute_features(X_coefs, n_feats) );
   // scale features
   FdPot::scale_features(feats);
-#ifndef MYNDEBUG
-  std::cout << "Creating ORCT with following params" << std::endl;
-  std::cout << "Depth " << Rcpp::as<int>(fit_results["depth"]) << std::endl;
-  std::cout << "N_feats " <<   Rcpp::as<int>(fit_results["n_feats"]) << std::endl;
-  std::cout << "n labels: " <<  Rcpp::as<int>(fit_results["n_labels"]) << std::endl;
-#endif 
-  ORCT tree = ORCT(fit_results["depth"], fit_results["n_feats"], 
-                   fit_results["n_labels"], fitted_tree["gamma"]
-                     );
+  
+  // trees fitted with the L1 penalty only use their surviving weights
+  if (fitted_tree.containsElementNamed("l1_lambda") and 
+        Rcpp::as<double>(fitted_tree["l1_lambda"]) > 0.)
+    return tree.predict(feats, tree.sparsify(
+        vars, Rcpp::as<double>(fitted_tree["sparsity_tol"])));
 
   return tree.predict(feats, vars);
 }
 
+//' Predict the labels of new functional data with a fitted forest
+//' 
+//' @description The features of the new data are computed and scaled once (on their own, as in predict_FdPot_Rcpp); the probabilities of the labels are the mean of those of the trees
+//' @param fitted_forest the list returned by forest_pFdorct_Rcpp
+//' @param X_coefs p x n matrix with the coefficients of the new functional data
+//' @return same list as predict_FdPot_Rcpp
+// [[Rcpp::export]]
+Rcpp::List predict_forest_Rcpp(const Rcpp::List& fitted_forest,
+                               const arma::mat& X_coefs){
+  Rcpp::List forest_results = Rcpp::as<Rcpp::List>(fitted_forest["forest_results"]);
+  auto fd_handler = fd_handler_of(fitted_forest);
+  auto feats = arma::mat(fd_handler.compute_features(
+    X_coefs, Rcpp::as<unsigned>(forest_results["n_feats"])));
+  FdPot::scale_features(feats);
+  
+  const ORCT tree(fitted_forest["depth"], forest_results["tree_feats"],
+                  fitted_forest["n_labels"], fitted_forest["gamma"]);
+  const Rcpp::NumericMatrix variables = forest_results["variables"];
+  // written in place in the R objects
+  Rcpp::NumericMatrix probs(feats.n_rows, tree.n_labels);
+  Rcpp::NumericVector labels(feats.n_rows);
+  arma::mat probs_mat = mat_view(probs);
+  Forest::predict_probs(feats, tree, mat_view(variables),
+                        Rcpp::as<arma::umat>(forest_results["feature_idx"]), probs_mat);
+  for (unsigned i = 0; i < probs_mat.n_rows; i++)
+    labels[i] = probs_mat.row(i).index_max();
+  return Rcpp::List::create(_("predicted_labels_probs") = probs,
+                            _("predicted_labels") = labels);
+}
+
+//' Compare the single and double precision prediction paths
+//' 
+//' @description Runs both versions of the prediction on the same data and reports how much the probabilities differ
+//' @param fitted_tree the list returned by pFdorct_Rcpp
+//' @param X_coefs p x n matrix with the coefficients of the functional data to score
+//' @param result_idx which of the fitted solutions to use (0-based)
+//' @return a list with the maximum and mean absolute difference of the probabilities, the fraction of equal predicted labels and the features' maximum absolute difference
+// [[Rcpp::export]]
+Rcpp::List compare_precision_FdPot_Rcpp(const Rcpp::List& fitted_tree,
+                                        const arma::mat& X_coefs,
+                                        const unsigned result_idx){
+  Rcpp::List fit_results = Rcpp::as<Rcpp::List>(fitted_tree["fit_results"]);
+  auto fd_handler = fd_handler_of(fitted_tree);
+  const unsigned n_feats = Rcpp::as<unsigned>(fit_results["n_feats"]);
+  const Rcpp::NumericMatrix all_variables = fit_results["all_variables"];
+  arma::vec vars = mat_view(all_variables).col(result_idx);
+  ORCT tree = orct_of(fitted_tree);
+  
+  arma::mat feats = fd_handler.compute_features(X_coefs, n_feats);
+  FdPot::scale_features(feats);
+  arma::fmat feats_single = fd_handler.compute_features_single(X_coefs, n_feats);
+  FdPot::scale_features(feats_single);
+  
+  arma::mat probs = tree.predict_probs(feats, vars);
+  arma::mat probs_single = arma::conv_to<arma::mat>::from(
+    tree.predict_probs(feats_single, arma::conv_to<arma::fvec>::from(vars)));
+  
+  arma::mat abs_diff = arma::abs(probs - probs_single);
+  arma::uvec labels(probs.n_rows), labels_single(probs.n_rows);
+  for (unsigned i = 0; i < probs.n_rows; i++){
+    labels(i) = probs.row(i).index_max();
+    labels_single(i) = probs_single.row(i).index_max();
+  }
+  
+  return Rcpp::List::create(
+    _("n_samples") = probs.n_rows,
+    _("max_abs_diff_probs") = abs_diff.max(),
+    _("mean_abs_diff_probs") = arma::mean(arma::vectorise(abs_diff)),
+    _("label_agreement") = arma::mean(arma::conv_to<arma::vec>::from(labels == labels_single)),
+    _("max_abs_diff_feats") = arma::abs(feats - arma::conv_to<arma::mat>::from(feats_single)).max()
+  );
+}
+
+//' The objective and its gradient as a backend gives them to Ipopt
+//' 
+//' @description Sets the problem up as pFdorct_Rcpp does and evaluates the objective and its gradient at n_points random points, without solving: the points are the random starting points of the restarts, hence the same for every backend, and the results of two backends can be compared.
+//' @param n_points the number of points
+//' @param y,X_coeffs,X_argvals,X_basis_df,X_basis_degree,depth,alpha,n_feats,gamma,seed,l1_lambda,backend see pFdorct_Rcpp
+//' @return a list with the points, the values of the objective and its gradients (one column per point)
+// [[Rcpp::export]]
+Rcpp::List derivatives_FdPot_Rcpp(const arma::vec & y, 
+                                  const arma::mat&  X_coeffs,
+                                  const Rcpp::NumericVector & X_argvals,
+                                  int X_basis_df,
+                                  int X_basis_degree,
+                                  int depth = 2,
+                                  double alpha = .1,
+                                  unsigned n_feats = 10,
+                                  double gamma = 512.,
+                                  long int seed = 41703192,
+                                  double l1_lambda = 0.,
+                                  const Rcpp::String& backend = "cppad",
+                                  unsigned n_points = 5){
+  if (y.size() != X_coeffs.n_cols)
+    Rcpp::stop("Number of rows in the coefficients matrix must conform to the number of labels");
+  if (depth < 1)
+    Rcpp::stop("depth must be at least 1");
+  if (l1_lambda < 0.)
+    Rcpp::stop("l1_lambda must be non-negative");
+  arma::vec boundary_knots{ X_argvals[0], X_argvals[X_argvals.size()-1] };
+  auto basis = splines2::BSpline(X_argvals, X_basis_df, X_basis_degree,
+                                 boundary_knots);
+  const unsigned n_labels = arma::vec(arma::unique(y)).n_rows;
+  FdPot tree = FdPot(std::move(basis), n_labels, X_coeffs.n_cols, n_feats, depth, alpha,
+                     seed, gamma, l1_lambda, 1e-4, 1, backend_of(backend), SolverConfig());
+  return tree.derivatives(y, X_coeffs, n_points);
+}
+
 // [[Rcpp::export]]
 arma::mat compute_func_datum_integral(const arma::vec & coefs,
                                    const Rcpp::NumericVector& X_argvals,
@@ -0,0 +1,113 @@
+#include "RestartRace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace fdpot{
+
+RestartRace::RestartRace(const RacingConfig& config_, const unsigned n_restarts_,
+                         const int max_iter_):
+  config(config_), n_restarts(n_restarts_), max_iter(max_iter_),
+  iterations(n_restarts_, arma::fill::zeros), culled_round(n_restarts_, arma::fill::zeros),
+  finished(n_restarts_, arma::fill::zeros), converged(n_restarts_, arma::fill::zeros) {}
+
+std::vector<unsigned> RestartRace::next_round(std::vector<OptimHandler>& handlers,
+                                              const std::vector<std::string>& errors){
+  using result = CppAD::ipopt::solve_result<arma::vec>;
+  // outcome of the previous round
+  for (auto m: this->last_round){
+    this->iterations(m) += handlers[m].iter_log.iterations;
+    const auto status = handlers[m].solution.status;
+    if (not errors[m].empty()){  // out of the race
+      this->finished(m) = 1;
+      this->culled_round(m) = this->round;
+    }
+    else if (status != result::user_requested_stop){  // the budget was not hit
+      this->finished(m) = 1;
+      this->converged(m) = status == result::success or
+        status == result::stop_at_acceptable_point;
+    }
+  }
+
+  std::vector<unsigned> alive;
+  bool running = false;
+  for (unsigned m = 0; m < this->n_restarts; m++)
+    if (not this->culled(m)){
+      alive.push_back(m);
+      running |= not this->finished(m);
+    }
+
+  // keep the best ones: feasible first, then by objective
+  if (this->round > 0 and running and alive.size() > this->config.min_survivors){
+    auto score = [&handlers, this](const unsigned m){
+      const double obj = handlers[m].solution.obj_value;
+      return std::make_pair(handlers[m].iter_log.inf_pr > this->config.feasibility_tol,
+                            std::isnan(obj) ? std::numeric_limits<double>::infinity() : obj);
+    };
+    std::stable_sort(alive.begin(), alive.end(), [&score](const unsigned a, const unsigned b){
+      return score(a) < score(b);
+    });
+    const unsigned keep = std::max(this->config.min_survivors, static_cast<unsigned>(
+      std::ceil(this->config.keep_fraction * alive.size())));
+    for (unsigned k = keep; k < alive.size(); k++)
+      this->culled_round(alive[k]) = this->round;
+    alive.resize(keep);
+  }
+
+  // cumulative budget of the round; the last one has no budget
+  const double budget = this->config.initial_iter * std::pow(this->config.growth, this->round);
+  const bool last = alive.size() <= this->config.min_survivors or budget >= this->max_iter;
+  this->last_round.clear();
+  for (auto m: alive){
+    if (this->finished(m))
+      continue;
+    auto& hdler = handlers[m];
+    if (this->round > 0){  // continue from the last iterate
+      hdler.variables = hdler.solution.x;
+      hdler.zl0 = hdler.solution.zl;
+      hdler.zu0 = hdler.solution.zu;
+      hdler.lambda0 = hdler.solution.lambda;
+      hdler.mu0 = hdler.iter_log.mu;
+    }
+    if (last){
+      hdler.iter_budget = -1;
+      hdler.config.max_iter = std::max(1, this->max_iter - static_cast<int>(this->iterations(m)));
+    }
+    else
+      hdler.iter_budget = std::max(1, static_cast<int>(budget) -
+                                   static_cast<int>(this->iterations(m)));
+    this->last_round.push_back(m);
+  }
+  if (not this->last_round.empty())
+    this->round++;
+  return this->last_round;
+}
+
+Rcpp::List RestartRace::report(void) const{
+  const unsigned n_converged = arma::accu(this->converged);
+  double mean_converged = this->max_iter;
+  if (n_converged > 0)
+    mean_converged = arma::accu(this->iterations % this->converged) /
+      static_cast<double>(n_converged);
+  // the culled restarts that were still running would have gone on
+  double full_iterations = 0.;
+  for (unsigned m = 0; m < this->n_restarts; m++)
+    if (this->culled(m) and not this->finished(m))
+      full_iterations += std::max(mean_converged, static_cast<double>(this->iterations(m)));
+    else
+      full_iterations += this->iterations(m);
+  const double total_iterations = arma::accu(this->iterations);
+
+  return Rcpp::List::create(
+    Rcpp::_("rounds") = this->round,
+    Rcpp::_("iterations") = this->iterations,
+    Rcpp::_("culled_round") = this->culled_round,
+    Rcpp::_("total_iterations") = total_iterations,
+    Rcpp::_("estimated_full_iterations") = full_iterations,
+    Rcpp::_("saved_fraction") = full_iterations > 0. ?
+      1. - total_iterations / full_iterations : 0.
+  );
+}
+
+} // namespace fdpot
@@ -0,0 +1,67 @@
+#ifndef RESTART_RACE_HH
+#define RESTART_RACE_HH
+#include <string>
+#include <vector>
+
+#include "RcppArmadillo.h"
+#include "OptimHandler.h"
+#include "SolverConfig.h"
+
+namespace fdpot{
+
+/*! @brief Successive halving of the multistart restarts
+
+ @description Most restarts end in a local minimum that is clearly worse
+ than the best one long before Ipopt converges. The race gives every restart
+ a small budget of iterations (see OptimHandler::iter_budget), ranks the
+ restarts by the objective of their last iterate (the feasible ones first),
+ culls the worst ones and continues the others, warm started from their last
+ iterate and multipliers, with a larger budget. When only min_survivors are
+ left, or the budget reaches max_iter, they are solved to convergence.
+
+ Usage: run the restarts returned by next_round until it returns none.
+ */
+class RestartRace{
+public:
+  /*! @brief Constructor
+   @param config_ the options of the race
+   @param n_restarts_ the number of restarts
+   @param max_iter_ the maximum number of iterations of a restart
+   */
+  RestartRace(const RacingConfig& config_, const unsigned n_restarts_,
+              const int max_iter_);
+
+  /*! @brief Prepares the next round
+
+   Reads the outcome of the previous round from the handlers, culls the
+   worst restarts and sets budget and warm start of the others.
+   @param handlers the handlers of all the restarts
+   @param errors the error message of each restart, empty if none
+   @return the restarts to solve, none when the race is over
+   */
+  std::vector<unsigned> next_round(std::vector<OptimHandler>& handlers,
+                                   const std::vector<std::string>& errors);
+
+  /*! @brief whether a restart was culled (it cannot be the best one) */
+  inline bool culled(const unsigned m) const{ return this->culled_round(m) > 0; }
+
+  /*! @brief The summary of the race, to be stored in the results
+
+   The iterations a full solve of the culled restarts would have taken are
+   estimated with the mean of the restarts that converged.
+   */
+  Rcpp::List report(void) const;
+
+private:
+  const RacingConfig config;
+  const unsigned n_restarts;
+  const int max_iter;
+  unsigned round = 0;
+  // cumulative iterations, round at which culled (0 if not), whether done
+  arma::uvec iterations, culled_round, finished, converged;
+  std::vector<unsigned> last_round;
+};
+
+} // namespace fdpot
+
+#endif
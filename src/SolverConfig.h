@@ -0,0 +1,231 @@
+#ifndef SOLVER_CONFIG_HH
+#define SOLVER_CONFIG_HH
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief How the derivatives given to Ipopt are computed
+
+ CPPAD: from the recorded tape (exact Hessian of the Lagrangian available).
+ NATIVE: from the closed form gradient of OrctObjective, no tape, and the
+ limited-memory approximation of the Hessian.
+ STOCHASTIC: no Ipopt, mini-batch first order method (see StochasticTrainer).
+ */
+enum class OptimBackend{
+  CPPAD = 0,
+  NATIVE,
+  STOCHASTIC
+};
+
+/*! @brief The options of the stochastic mini-batch trainer
+
+ @description Used by the STOCHASTIC backend only (see StochasticTrainer).
+ */
+struct StochasticConfig{
+  /*! @brief "adam" or "sgd" */
+  std::string method = "adam";
+  /*! @brief the step size */
+  double learning_rate = 0.01;
+  /*! @brief samples of the cost term in each step */
+  unsigned batch_size = 256;
+  /*! @brief pairs of the penalty term in each step */
+  unsigned pair_batch_size = 4096;
+  /*! @brief maximum number of passes over the training samples */
+  unsigned max_epochs = 200;
+  /*! @brief fraction of the samples held out to monitor the convergence */
+  double holdout_fraction = 0.1;
+  /*! @brief epochs without improvement of the held-out objective before stopping */
+  unsigned patience = 10;
+  /*! @brief relative improvement below which an epoch does not count as one */
+  double rel_tol = 1e-4;
+  /*! @brief weight of the quadratic penalty on the "at least one leaf per class" constraints */
+  double coverage_weight = 10.;
+
+  /*! @brief The configuration as a named list, to be stored in the results */
+  inline Rcpp::List to_list(void) const{
+    return Rcpp::List::create(
+      Rcpp::_("method") = this->method,
+      Rcpp::_("learning_rate") = this->learning_rate,
+      Rcpp::_("batch_size") = this->batch_size,
+      Rcpp::_("pair_batch_size") = this->pair_batch_size,
+      Rcpp::_("max_epochs") = this->max_epochs,
+      Rcpp::_("holdout_fraction") = this->holdout_fraction,
+      Rcpp::_("patience") = this->patience,
+      Rcpp::_("rel_tol") = this->rel_tol,
+      Rcpp::_("coverage_weight") = this->coverage_weight
+    );
+  }
+};
+
+/*! @brief The options of the successive-halving race of the restarts
+
+ @description Used with the Ipopt backends (see RestartRace): all the
+ restarts get initial_iter iterations, the best keep_fraction of them go on
+ with a budget multiplied by growth, and so on until min_survivors are left,
+ which are solved to convergence.
+ */
+struct RacingConfig{
+  /*! @brief whether the restarts race, otherwise each one is solved to convergence */
+  bool enabled = false;
+  /*! @brief iterations of the first round */
+  int initial_iter = 10;
+  /*! @brief fraction of the restarts kept after each round */
+  double keep_fraction = 0.5;
+  /*! @brief factor of the (cumulative) iteration budget from a round to the next */
+  double growth = 2.;
+  /*! @brief restarts solved to convergence */
+  unsigned min_survivors = 2;
+  /*! @brief primal infeasibility above which an iterate is ranked after the feasible ones */
+  double feasibility_tol = 1e-6;
+
+  /*! @brief The configuration as a named list, to be stored in the results */
+  inline Rcpp::List to_list(void) const{
+    return Rcpp::List::create(
+      Rcpp::_("racing") = this->enabled,
+      Rcpp::_("racing_initial_iter") = this->initial_iter,
+      Rcpp::_("racing_keep_fraction") = this->keep_fraction,
+      Rcpp::_("racing_growth") = this->growth,
+      Rcpp::_("racing_min_survivors") = this->min_survivors,
+      Rcpp::_("racing_feasibility_tol") = this->feasibility_tol
+    );
+  }
+};
+
+/*! @brief The Ipopt options used by OptimHandler::solve
+
+ @description The defaults favour speed: the Hessian of the Lagrangian is
+ approximated with limited-memory BFGS (so that the dense Hessian of the
+ penalty is never built), the tolerance is Ipopt's default one and there is
+ no derivative test.
+ The names of the members are the ones of the Ipopt options.
+ */
+struct SolverConfig{
+  /*! @brief "limited-memory" or "exact" */
+  std::string hessian_approximation = "limited-memory";
+  /*! @brief the desired convergence tolerance (relative) */
+  double tol = 1e-8;
+  /*! @brief the tolerance of the "acceptable" termination */
+  double acceptable_tol = 1e-6;
+  /*! @brief the maximum number of iterations */
+  int max_iter = 1000;
+  /*! @brief "none", "first-order", "second-order" or "only-second-order" */
+  std::string derivative_test = "none";
+  /*! @brief the linear solver, it must be available in the Ipopt build */
+  std::string linear_solver = "mumps";
+  /*! @brief verbosity of Ipopt, from 0 (silent) to 12 */
+  int print_level = 0;
+  /*! @brief the options of the STOCHASTIC backend */
+  StochasticConfig stochastic;
+  /*! @brief the race of the restarts (Ipopt backends only) */
+  RacingConfig racing;
+  /*! @brief starting points of the restarts: "random" (uniform split 
+   weights, flat Dirichlet leaves), "cart" (a greedy tree, see GreedyInit: 
+   the first restart on all the samples, the others on bootstrap samples)
+   or "mixed" (even restarts as "cart", odd ones as "random")
+   */
+  std::string init = "random";
+  
+  /*! @brief whether restart m starts from a greedy tree (see init) */
+  inline bool cart_start(const unsigned m) const{
+    return this->init == "cart" or (this->init == "mixed" and m % 2 == 0);
+  }
+
+  /*! @brief The options actually used with a backend
+
+   The other backends have no Hessian: the approximation is forced to
+   limited-memory and the derivative test to first order at most. The
+   STOCHASTIC backend does not race its restarts.
+   @param backend the backend
+   @return the adjusted copy of this configuration
+   */
+  inline SolverConfig effective(const OptimBackend backend) const{
+    SolverConfig eff(*this);
+    if (backend != OptimBackend::CPPAD){
+      eff.hessian_approximation = "limited-memory";
+      if (eff.derivative_test != "none")
+        eff.derivative_test = "first-order";
+    }
+    if (backend == OptimBackend::STOCHASTIC)
+      eff.racing.enabled = false;
+    return eff;
+  }
+
+  /*! @brief whether several restarts can be solved at the same time in one
+   process: Ipopt is reentrant only with a thread-safe linear solver (the
+   HSL ones, SPRAL, MKL's Pardiso), and MUMPS, the default, is not one. The
+   STOCHASTIC backend does not use Ipopt.
+   */
+  inline bool concurrent_solves(const OptimBackend backend) const{
+    static const char* thread_safe[] = {"ma27", "ma57", "ma77", "ma86", "ma97",
+                                        "spral", "pardisomkl"};
+    if (backend == OptimBackend::STOCHASTIC)
+      return true;
+    for (auto solver: thread_safe)
+      if (this->linear_solver == solver)
+        return true;
+    return false;
+  }
+
+  /*! @brief the threads that may solve concurrently: n_threads, or 1 if
+   the solves cannot be concurrent (see concurrent_solves)
+   */
+  inline unsigned solve_threads(const unsigned n_threads, const OptimBackend backend) const{
+    return this->concurrent_solves(backend) ? n_threads : std::min(n_threads, 1u);
+  }
+
+  /*! @brief whether Ipopt will ask for the Hessian of the Lagrangian */
+  inline bool exact_hessian(void) const{
+    return this->hessian_approximation == "exact";
+  }
+
+  /*! @brief The options string, in the format of CppAD::ipopt::solve
+   (see apply_ipopt_options)
+   */
+  inline std::string ipopt_options(void) const{
+    std::ostringstream options;
+    options.precision(17);
+    options << "String  sb                     yes\n";
+    options << "Integer print_level            " << this->print_level << "\n";
+    options << "String  hessian_approximation  " << this->hessian_approximation << "\n";
+    options << "Numeric tol                    " << this->tol << "\n";
+    options << "Numeric acceptable_tol         " << this->acceptable_tol << "\n";
+    options << "Integer max_iter               " << this->max_iter << "\n";
+    options << "String  linear_solver          " << this->linear_solver << "\n";
+    options << "String  derivative_test        " << this->derivative_test << "\n";
+    if (this->derivative_test != "none")
+      // maximum amount of random pertubation when evaluating finite diff
+      options << "Numeric point_perturbation_radius  0.\n";
+    return options.str();
+  }
+
+  /*! @brief The configuration as a named list, to be stored in the results
+   @param backend the stochastic options are listed only for the STOCHASTIC
+   backend, the Ipopt ones for the others
+   */
+  inline Rcpp::List to_list(const OptimBackend backend) const{
+    if (backend == OptimBackend::STOCHASTIC){
+      Rcpp::List options = this->stochastic.to_list();
+      options["init"] = this->init;
+      return options;
+    }
+    return Rcpp::List::create(
+      Rcpp::_("hessian_approximation") = this->hessian_approximation,
+      Rcpp::_("tol") = this->tol,
+      Rcpp::_("acceptable_tol") = this->acceptable_tol,
+      Rcpp::_("max_iter") = this->max_iter,
+      Rcpp::_("derivative_test") = this->derivative_test,
+      Rcpp::_("linear_solver") = this->linear_solver,
+      Rcpp::_("print_level") = this->print_level,
+      Rcpp::_("racing") = this->racing.to_list(),
+      Rcpp::_("init") = this->init
+    );
+  }
+};
+
+} // namespace fdpot
+
+#endif
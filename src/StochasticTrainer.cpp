@@ -0,0 +1,142 @@
+#include "StochasticTrainer.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace fdpot{
+
+void project_on_simplex(double* v, const unsigned n){
+  // see Duchi et al. (2008), "Efficient projections onto the l1-ball"
+  std::vector<double> u(v, v + n);
+  std::sort(u.begin(), u.end(), std::greater<double>());
+  double cumsum = 0., theta = 0.;
+  for (unsigned j = 0; j < n; j++){
+    cumsum += u[j];
+    const double t = (cumsum - 1.) / (j + 1);
+    if (u[j] - t > 0.)
+      theta = t;
+  }
+  for (unsigned j = 0; j < n; j++)
+    v[j] = std::max(v[j] - theta, 0.);
+}
+
+void StochasticTrainer::project(Dvector& x, const Dvector& xl, const Dvector& xu) const{
+  x = arma::min(arma::max(x, xl), xu);  // the bounds (exact for the split variables)
+  for (unsigned leaf = this->orct.n_int_nodes; leaf < this->orct.n_nodes; leaf++)
+    project_on_simplex(x.memptr() + this->orct.var_map(leaf), this->orct.n_labels);
+}
+
+double StochasticTrainer::coverage_penalty(const Dvector& x, Dvector& grad) const{
+  double penalty = 0.;
+  for (unsigned k = 0; k < this->orct.n_labels; k++){
+    double sum = 0.;
+    for (unsigned leaf = this->orct.n_int_nodes; leaf < this->orct.n_nodes; leaf++)
+      sum += x[this->orct.var_map(leaf) + k];
+    const double violation = std::max(1. - sum, 0.);
+    penalty += 0.5 * this->config.coverage_weight * violation * violation;
+    for (unsigned leaf = this->orct.n_int_nodes; leaf < this->orct.n_nodes; leaf++)
+      grad[this->orct.var_map(leaf) + k] -= this->config.coverage_weight * violation;
+  }
+  return penalty;
+}
+
+arma::umat StochasticTrainer::draw_pairs(const arma::uvec& samples, const unsigned n_pairs){
+  arma::umat pairs(n_pairs, 2);
+  std::uniform_int_distribution<unsigned> first(0, samples.n_elem - 1),
+    second(0, samples.n_elem - 2);
+  for (unsigned r = 0; r < n_pairs; r++){
+    const unsigned a = first(this->engine);
+    unsigned b = second(this->engine);
+    if (b >= a)  // uniform on the other samples
+      b++;
+    pairs(r, 0) = samples(a);
+    pairs(r, 1) = samples(b);
+  }
+  return pairs;
+}
+
+unsigned StochasticTrainer::train(const Dvector& x0, const Dvector& xl, const Dvector& xu,
+                                  CppAD::ipopt::solve_result<Dvector>& solution){
+  const unsigned n = this->objective.n_samples(), n_vars = x0.n_elem;
+  // a pair of samples at least is needed for the penalty and for the split
+  // in training and held-out samples
+  if (n < 2)
+    throw std::runtime_error("Error: the stochastic backend needs at least 2 samples");
+  
+  // held-out samples
+  std::vector<unsigned> order(n);
+  std::iota(order.begin(), order.end(), 0u);
+  std::shuffle(order.begin(), order.end(), this->engine);
+  const unsigned n_holdout = std::min(n - 2, static_cast<unsigned>(
+    std::ceil(this->config.holdout_fraction * n)));
+  arma::uvec holdout(n_holdout), train(n - n_holdout);
+  for (unsigned a = 0; a < n; a++)
+    if (a < n_holdout)
+      holdout(a) = order[a];
+    else
+      train(a - n_holdout) = order[a];
+  const arma::uvec& monitor = n_holdout > 1 ? holdout : train;
+  
+  const unsigned batch_size = std::min<unsigned>(this->config.batch_size, train.n_elem);
+  const unsigned n_pairs = this->config.pair_batch_size;
+  // unbiased estimate of the sum over all the pairs of the sample
+  const double pair_weight = 0.5 * n * (n - 1.) / std::max(n_pairs, 1u);
+  const bool adam = this->config.method == "adam";
+  const double beta1 = .9, beta2 = .999, eps = 1e-8;
+  
+  Dvector x = x0, grad(n_vars), m(n_vars, arma::fill::zeros), v(n_vars, arma::fill::zeros);
+  this->project(x, xl, xu);
+  Dvector best_x = x;
+  double best_value = this->objective.subset_value(x.memptr(), monitor);
+  unsigned since_best = 0, epoch = 0, step = 0;
+  
+  for (epoch = 0; epoch < this->config.max_epochs and 
+         since_best < this->config.patience; epoch++){
+    // from the seed of the restart: arma::shuffle would draw from R's
+    // generator, which the threads and the worker processes cannot share
+    std::shuffle(train.begin(), train.end(), this->engine);
+    for (unsigned first = 0; first < train.n_elem; first += batch_size){
+      const arma::uvec batch = train.subvec(
+        first, std::min(first + batch_size, train.n_elem) - 1);
+      const arma::umat pairs = this->draw_pairs(train, n_pairs);
+      
+      this->objective.batch_gradient(x.memptr(), batch, pairs, pair_weight,
+                                     grad.memptr());
+      this->coverage_penalty(x, grad);
+      
+      step++;
+      if (adam){
+        m = beta1 * m + (1. - beta1) * grad;
+        v = beta2 * v + (1. - beta2) * arma::square(grad);
+        const double lr = this->config.learning_rate * 
+          std::sqrt(1. - std::pow(beta2, step)) / (1. - std::pow(beta1, step));
+        x -= lr * m / (arma::sqrt(v) + eps);
+      }
+      else
+        x -= this->config.learning_rate * grad;
+      this->project(x, xl, xu);
+    }
+    
+    const double value = this->objective.subset_value(x.memptr(), monitor);
+    if (value < best_value - this->config.rel_tol * std::abs(best_value)){
+      best_value = value;
+      best_x = x;
+      since_best = 0;
+    }
+    else
+      since_best++;
+  }
+  
+  solution.status = since_best >= this->config.patience ?
+    CppAD::ipopt::solve_result<Dvector>::success :
+    CppAD::ipopt::solve_result<Dvector>::maxiter_exceeded;
+  solution.x = std::move(best_x);
+  solution.obj_value = this->objective.value(solution.x.memptr());
+  return epoch;
+}
+
+} // namespace fdpot
@@ -0,0 +1,82 @@
+#ifndef STOCHASTIC_TRAINER_HH
+#define STOCHASTIC_TRAINER_HH
+#include <cppad/ipopt/solve.hpp>
+#include <cstdint>
+#include <random>
+
+#include "RcppArmadillo.h"
+#include "OrctObjective.h"
+#include "SolverConfig.h"
+
+namespace fdpot{
+
+/*! @brief Mini-batch first order training of the ORCT
+
+ @description Ipopt evaluates the whole objective at every iteration, i.e.
+ all the samples for the cost and all the pairs for the penalty. This 
+ trainer minimises the same objective with Adam or SGD steps, each of which 
+ draws batch_size training samples for the cost and pair_batch_size random 
+ pairs of training samples for the penalty (see 
+ OrctObjective::batch_gradient).
+ 
+ The constraints are handled as follows:
+ - the bounds of the split variables by clipping;
+ - "one class per leaf" by projecting the class variables of every leaf on
+ the probability simplex after each step;
+ - "at least one leaf per class" by a quadratic penalty on its violation.
+ 
+ A fraction of the samples is held out: the objective on them is evaluated
+ after every epoch, the best point is kept, and the training stops when it 
+ has not improved for patience epochs.
+ */
+class StochasticTrainer{
+public:
+  using Dvector = arma::vec;
+  
+  /*! @brief Constructor
+   @param objective_ the objective (not owned)
+   @param config_ the options
+   @param seed_ the seed of the sampling
+   */
+  StochasticTrainer(const OrctObjective& objective_, const StochasticConfig& config_,
+                    const std::uint32_t seed_):
+    objective(objective_), orct(objective_.tree()), config(config_), engine(seed_) {};
+  
+  /*! @brief Trains from a starting point
+   @param x0 the starting point
+   @param xl, xu the bounds of the variables
+   @param solution where the best point is stored; its status is success if
+   the held-out objective stopped improving, maxiter_exceeded if max_epochs 
+   was reached first. obj_value is the objective on all the samples.
+   @return the number of epochs run
+   @throws std::runtime_error with fewer than 2 samples
+   */
+  unsigned train(const Dvector& x0, const Dvector& xl, const Dvector& xu,
+                 CppAD::ipopt::solve_result<Dvector>& solution);
+
+private:
+  const OrctObjective& objective;
+  const ORCT& orct;
+  const StochasticConfig config;
+  std::mt19937 engine;
+  
+  /*! @brief projects x on the feasible set of the bounds and of the simplices */
+  void project(Dvector& x, const Dvector& xl, const Dvector& xu) const;
+  
+  /*! @brief adds the gradient of the class coverage penalty to grad
+   @return the penalty
+   */
+  double coverage_penalty(const Dvector& x, Dvector& grad) const;
+  
+  /*! @brief draws n_pairs pairs (i, j), i != j, of elements of samples */
+  arma::umat draw_pairs(const arma::uvec& samples, const unsigned n_pairs);
+};
+
+/*! @brief Euclidean projection on the probability simplex
+ @param v the vector, projected in place
+ */
+void project_on_simplex(double* v, const unsigned n);
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,145 @@
+#include "TapedNLP.h"
+
+namespace fdpot{
+
+void ADTape::compute_sparsity(const bool with_hessian){
+  const size_t n = this->fun.Domain(), m = this->fun.Range();
+  this->jac_work.clear();
+  this->hes_work.clear();
+
+  // Jacobian pattern with the identity as seed
+  std::vector<std::set<size_t>> r(n);
+  for (size_t j = 0; j < n; j++)
+    r[j].insert(j);
+  this->jac_pattern = this->fun.ForSparseJac(n, r);
+
+  // Hessian of the Lagrangian: every component of fg has a weight
+  this->hes_pattern.clear();
+  if (with_hessian){
+    std::vector<std::set<size_t>> s(1);
+    for (size_t i = 0; i < m; i++)
+      s[0].insert(i);
+    this->hes_pattern = this->fun.RevSparseHes(n, s);
+  }
+
+  // the objective (row 0) is not part of the constraints Jacobian
+  this->jac_row.clear();
+  this->jac_col.clear();
+  for (size_t i = 1; i < m; i++)
+    for (auto j: this->jac_pattern[i]){
+      this->jac_row.push_back(i);
+      this->jac_col.push_back(j);
+    }
+  // Ipopt wants the lower triangle only
+  this->hes_row.clear();
+  this->hes_col.clear();
+  for (size_t i = 0; i < this->hes_pattern.size(); i++)
+    for (auto j: this->hes_pattern[i])
+      if (j <= i){
+        this->hes_row.push_back(i);
+        this->hes_col.push_back(j);
+      }
+}
+
+std::shared_ptr<ADTape> ADTape::copy(void) const{
+  auto tape_copy = std::make_shared<ADTape>();
+  tape_copy->fun = this->fun;
+  tape_copy->jac_pattern = this->jac_pattern;
+  tape_copy->hes_pattern = this->hes_pattern;
+  tape_copy->jac_row = this->jac_row;
+  tape_copy->jac_col = this->jac_col;
+  tape_copy->hes_row = this->hes_row;
+  tape_copy->hes_col = this->hes_col;
+  tape_copy->record_seconds = this->record_seconds;
+  return tape_copy;
+}
+
+void TapedNLP::forward_zero(const Number* x, bool new_x){
+  if (not new_x and this->x_cur.size() == this->n)
+    return;
+  this->x_cur.assign(x, x + this->n);
+  this->fg_cur = this->tape.fun.Forward(0, this->x_cur);
+}
+
+bool TapedNLP::get_nlp_info(Index& n_, Index& m_, Index& nnz_jac_g,
+                            Index& nnz_h_lag, IndexStyleEnum& index_style){
+  n_ = this->n;
+  m_ = this->m;
+  nnz_jac_g = this->tape.jac_row.size();
+  nnz_h_lag = this->tape.hes_row.size();
+  index_style = C_STYLE;
+  return true;
+}
+
+bool TapedNLP::eval_f(Index n_, const Number* x, bool new_x, Number& obj_value){
+  this->forward_zero(x, new_x);
+  obj_value = this->fg_cur[0];
+  return true;
+}
+
+bool TapedNLP::eval_grad_f(Index n_, const Number* x, bool new_x, Number* grad_f){
+  // the sparse derivatives may have moved the zero order coefficients
+  this->forward_zero(x, true);
+  std::vector<double>& w = this->tape.scratch.w;
+  w.assign(this->m + 1, 0.);
+  w[0] = 1.;
+  const std::vector<double> grad = this->tape.fun.Reverse(1, w);
+  for (Index j = 0; j < n_; j++)
+    grad_f[j] = grad[j];
+  return true;
+}
+
+bool TapedNLP::eval_g(Index n_, const Number* x, bool new_x, Index m_, Number* g){
+  this->forward_zero(x, new_x);
+  for (Index i = 0; i < m_; i++)
+    g[i] = this->fg_cur[i + 1];
+  return true;
+}
+
+bool TapedNLP::eval_jac_g(Index n_, const Number* x, bool new_x, Index m_,
+                          Index nele_jac, Index* iRow, Index* jCol, Number* values){
+  if (values == nullptr){  // structure only
+    for (Index k = 0; k < nele_jac; k++){
+      iRow[k] = this->tape.jac_row[k] - 1;
+      jCol[k] = this->tape.jac_col[k];
+    }
+    return true;
+  }
+  auto& scratch = this->tape.scratch;
+  scratch.x.assign(x, x + n_);
+  scratch.values.resize(nele_jac);
+  this->tape.fun.SparseJacobianReverse(scratch.x, this->tape.jac_pattern,
+                                       this->tape.jac_row, this->tape.jac_col,
+                                       scratch.values, this->tape.jac_work);
+  std::copy(scratch.values.cbegin(), scratch.values.cend(), values);
+  // the sweeps above leave the tape at x
+  this->x_cur.clear();
+  return true;
+}
+
+bool TapedNLP::eval_h(Index n_, const Number* x, bool new_x, Number obj_factor,
+                      Index m_, const Number* lambda, bool new_lambda,
+                      Index nele_hess, Index* iRow, Index* jCol, Number* values){
+  if (values == nullptr){  // structure only
+    for (Index k = 0; k < nele_hess; k++){
+      iRow[k] = this->tape.hes_row[k];
+      jCol[k] = this->tape.hes_col[k];
+    }
+    return true;
+  }
+  auto& scratch = this->tape.scratch;
+  scratch.x.assign(x, x + n_);
+  scratch.w.resize(m_ + 1);
+  scratch.values.resize(nele_hess);
+  scratch.w[0] = obj_factor;
+  for (Index i = 0; i < m_; i++)
+    scratch.w[i + 1] = lambda[i];
+  this->tape.fun.SparseHessian(scratch.x, scratch.w, this->tape.hes_pattern,
+                               this->tape.hes_row, this->tape.hes_col,
+                               scratch.values, this->tape.hes_work);
+  std::copy(scratch.values.cbegin(), scratch.values.cend(), values);
+  this->x_cur.clear();
+  return true;
+}
+
+} // namespace fdpot
@@ -0,0 +1,164 @@
+#ifndef TAPED_NLP_HH
+#define TAPED_NLP_HH
+#include <cppad/ipopt/solve.hpp>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "BoundedNLP.h"
+
+namespace fdpot{
+
+/*! @brief The recorded objective and constraints functions
+
+ The ORCT objective has no conditional expressions, hence its operation
+ sequence does not depend on the point at which it is recorded: the tape
+ can be recorded (and optimised) once per fit and then used by all the
+ restarts, which only differ for their starting point.
+ The sparsity patterns of the Jacobian and of the Hessian of the Lagrangian,
+ as well as the CppAD work objects (which cache the colouring), are kept
+ with the tape for the same reason.
+ */
+struct ADTape{
+  /*! @brief the recorded function: fg[0] is the objective, fg[1:] the constraints */
+  CppAD::ADFun<double> fun;
+  /*! @brief sparsity pattern of the Jacobian of fg (all of its rows) */
+  std::vector<std::set<size_t>> jac_pattern;
+  /*! @brief sparsity pattern of the Hessian of the Lagrangian (empty if not
+   needed, see record) */
+  std::vector<std::set<size_t>> hes_pattern;
+  /*! @brief nonzero entries of the constraints Jacobian (rows of fg, from 1) */
+  std::vector<size_t> jac_row, jac_col;
+  /*! @brief nonzero entries of the lower triangle of the Hessian */
+  std::vector<size_t> hes_row, hes_col;
+  /*! @brief CppAD caches for the sparse derivatives */
+  CppAD::sparse_jacobian_work jac_work;
+  CppAD::sparse_hessian_work hes_work;
+  /*! @brief buffers of the evaluations of TapedNLP (point, weights and
+   nonzero values), reused by all the solves on this tape; not copied */
+  struct Scratch{
+    std::vector<double> x, w, values;
+  } scratch;
+  /*! @brief wall time spent recording and optimising the tape [s] */
+  double record_seconds = 0.;
+
+  /*! @brief Records the tape of fg
+
+   @tparam FG_evalT the functor evaluating fg (see FG_eval in OptimHandler.h)
+   @param fg_eval the functor
+   @param x0 the point at which the operations are recorded
+   @param n_constraints the number of constraints functions
+   @param with_hessian whether the Hessian pattern is needed; it is not
+   with a quasi-Newton approximation, and it is the most expensive one
+   @param dynamic parameters read by fg_eval that are recorded as CppAD 
+   dynamic parameters, so that they can be changed without recording again
+   (see set_dynamic); they are left as constants with the same value
+   */
+  template<typename FG_evalT>
+  void record(FG_evalT& fg_eval, const arma::vec& x0, const unsigned n_constraints,
+              const bool with_hessian = true,
+              const std::vector<CppAD::AD<double>*>& dynamic = {});
+  
+  /*! @brief Changes the values of the dynamic parameters
+   @param values one value per dynamic parameter given to record
+   */
+  inline void set_dynamic(const std::vector<double>& values){
+    this->fun.new_dynamic(values);
+  }
+  
+  /*! @brief Copies the recorded tape and the sparsity patterns
+  
+   Zero order sweeps write in the ADFun, hence concurrent solves need one 
+   copy each; copying is much cheaper than recording again. The work objects
+   and the scratch buffers are not copied (the copy rebuilds them at its first use), and the copy
+   should be done by the thread that will use it, so that CppAD's 
+   thread_alloc assigns the memory to it.
+   @return the copy
+   */
+  std::shared_ptr<ADTape> copy(void) const;
+
+private:
+  /*! @brief Computes the sparsity patterns and the nonzero entries
+   @param with_hessian see record
+   */
+  void compute_sparsity(const bool with_hessian);
+};
+
+/*! @brief Ipopt problem whose derivatives come from an ADTape
+
+ @description It plays the role of the callback class CppAD::ipopt::solve
+ builds internally, except that the tape is received already recorded.
+ */
+class TapedNLP: public BoundedNLP{
+public:
+  /*! @brief Constructor
+   @param tape_ the recorded functions (not owned)
+   @param x0_ the starting point
+   @param xl_, xu_ bounds of the variables
+   @param gl_, gu_ bounds of the constraints
+   @param solution_ where to store the solution (not owned)
+   */
+  TapedNLP(ADTape& tape_, const Dvector& x0_,
+           const Dvector& xl_, const Dvector& xu_,
+           const Dvector& gl_, const Dvector& gu_,
+           CppAD::ipopt::solve_result<Dvector>& solution_):
+    BoundedNLP(x0_, xl_, xu_, gl_, gu_, solution_), tape(tape_) {};
+
+  bool get_nlp_info(Index& n_, Index& m_, Index& nnz_jac_g, Index& nnz_h_lag,
+                    IndexStyleEnum& index_style) override;
+
+  bool eval_f(Index n_, const Number* x, bool new_x, Number& obj_value) override;
+
+  bool eval_grad_f(Index n_, const Number* x, bool new_x, Number* grad_f) override;
+
+  bool eval_g(Index n_, const Number* x, bool new_x, Index m_, Number* g) override;
+
+  bool eval_jac_g(Index n_, const Number* x, bool new_x, Index m_, Index nele_jac,
+                  Index* iRow, Index* jCol, Number* values) override;
+
+  bool eval_h(Index n_, const Number* x, bool new_x, Number obj_factor,
+              Index m_, const Number* lambda, bool new_lambda,
+              Index nele_hess, Index* iRow, Index* jCol, Number* values) override;
+
+private:
+  ADTape& tape;
+  std::vector<double> x_cur;  // point of the last zero order forward sweep
+  std::vector<double> fg_cur;  // fg at x_cur
+
+  /*! @brief zero order forward sweep at x, if x is a new point */
+  void forward_zero(const Number* x, bool new_x);
+};
+
+template<typename FG_evalT>
+void ADTape::record(FG_evalT& fg_eval, const arma::vec& x0,
+                    const unsigned n_constraints, const bool with_hessian,
+                    const std::vector<CppAD::AD<double>*>& dynamic){
+  using ADvector = std::vector<CppAD::AD<double>>;
+  auto start = std::chrono::steady_clock::now();
+
+  ADvector ax(x0.cbegin(), x0.cend()), adynamic(dynamic.size());
+  for (size_t d = 0; d < dynamic.size(); d++)
+    adynamic[d] = CppAD::Value(*dynamic[d]);
+  if (dynamic.empty())
+    CppAD::Independent(ax);
+  else
+    CppAD::Independent(ax, adynamic);
+  for (size_t d = 0; d < dynamic.size(); d++)
+    *dynamic[d] = adynamic[d];  // now fg_eval reads the dynamic parameters
+  ADvector afg(1 + n_constraints);
+  fg_eval(afg, ax);
+  this->fun.Dependent(ax, afg);
+  for (size_t d = 0; d < dynamic.size(); d++)
+    *dynamic[d] = CppAD::Value(adynamic[d]);
+  // remove the operations that do not affect fg
+  this->fun.optimize();
+  this->compute_sparsity(with_hessian);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  this->record_seconds = elapsed.count();
+}
+
+} // namespace fdpot
+
+#endif
@@ -0,0 +1,207 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace fdpot{
+
+namespace {
+struct Event{
+  std::int64_t start;  // nanoseconds since the trace was configured
+  std::int64_t duration;  // -1 for an instant
+  const char* name;
+  const char* keys[3];
+  double values[3];
+  int level;
+  unsigned thread;
+};
+
+/*! @brief The ring buffer of a thread: written by it only, read by flush */
+struct Buffer{
+  explicit Buffer(const unsigned capacity, const unsigned thread_):
+    events(capacity), thread(thread_) {};
+  std::vector<Event> events;
+  std::atomic<std::uint64_t> head{0};  // events written so far
+  std::uint64_t tail = 0;  // events flushed (or dropped) so far
+  const unsigned thread;
+};
+
+struct State{
+  std::mutex mutex;  // guards the registration of the buffers
+  std::vector<std::shared_ptr<Buffer>> buffers;
+  std::atomic<unsigned> generation{0};  // changed by configure
+  unsigned capacity = 1u << 14;
+  std::string file;
+  std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+  unsigned long written = 0, dropped = 0;
+};
+
+State& state(void){
+  static State s;
+  return s;
+}
+
+/*! @brief The buffer of the calling thread, registered by its first event
+ (and again after configure)
+ */
+Buffer& thread_buffer(void){
+  thread_local std::shared_ptr<Buffer> buffer = nullptr;
+  thread_local unsigned generation = 0;
+  State& s = state();
+  const unsigned current = s.generation.load(std::memory_order_acquire);
+  if (buffer == nullptr or generation != current){
+    std::lock_guard<std::mutex> lock(s.mutex);
+    buffer = std::make_shared<Buffer>(s.capacity, s.buffers.size());
+    s.buffers.push_back(buffer);
+    generation = current;
+  }
+  return *buffer;
+}
+
+const char* level_name(const int level){
+  switch (level){
+    case 1: return "info";
+    case 2: return "debug";
+    default: return "verbose";
+  }
+}
+
+void write_json(std::ostream& out, const Event& e, const long pid){
+  out << "{\"name\":\"" << e.name << "\",\"cat\":\"" << level_name(e.level) <<
+    "\",\"pid\":" << pid << ",\"tid\":" << e.thread << ",\"ts\":" << e.start / 1e3;
+  if (e.duration >= 0)
+    out << ",\"ph\":\"X\",\"dur\":" << e.duration / 1e3;
+  else
+    out << ",\"ph\":\"i\",\"s\":\"t\"";
+  out << ",\"args\":{";
+  bool first = true;
+  for (unsigned k = 0; k < 3; k++)
+    if (e.keys[k] != nullptr){
+      out << (first ? "" : ",") << "\"" << e.keys[k] << "\":";
+      if (std::isfinite(e.values[k]))
+        out << e.values[k];
+      else  // not a JSON number
+        out << "\"" << e.values[k] << "\"";
+      first = false;
+    }
+  out << "}},\n";
+}
+
+void write_text(std::ostream& out, const Event& e){
+  out << "[" << level_name(e.level) << " " << e.start / 1e6 << " ms, thread " <<
+    e.thread << "] " << e.name;
+  for (unsigned k = 0; k < 3; k++)
+    if (e.keys[k] != nullptr)
+      out << " " << e.keys[k] << "=" << e.values[k];
+  if (e.duration >= 0)
+    out << " (" << e.duration / 1e6 << " ms)";
+  out << "\n";
+}
+} // anonymous namespace
+
+void Trace::configure(const Level level_, const std::string& file_,
+                      const unsigned capacity_){
+  State& s = state();
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.buffers.clear();  // the threads register new ones
+    s.capacity = std::max(capacity_, 1u);
+    s.file = file_;
+    s.epoch = std::chrono::steady_clock::now();
+    s.written = 0;
+    s.dropped = 0;
+    s.generation.fetch_add(1, std::memory_order_release);
+  }
+  if (not s.file.empty()){
+    // the JSON array is left open, as the format allows: flush appends to it
+    std::ofstream out(s.file, std::ios::trunc);
+    if (not out)
+      Rcpp::stop("cannot write the trace file " + s.file);
+    out << "[\n";
+  }
+  current_level.store(static_cast<int>(level_), std::memory_order_relaxed);
+}
+
+std::int64_t Trace::now(void){
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - state().epoch).count();
+}
+
+void Trace::record(const Level level_, const char* name, const std::int64_t start,
+                   const std::int64_t duration, const char* key1, const double value1,
+                   const char* key2, const double value2, const char* key3,
+                   const double value3){
+  Buffer& buffer = thread_buffer();
+  const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  Event& e = buffer.events[head % buffer.events.size()];
+  e.start = start;
+  e.duration = duration;
+  e.name = name;
+  e.keys[0] = key1;
+  e.keys[1] = key2;
+  e.keys[2] = key3;
+  e.values[0] = value1;
+  e.values[1] = value2;
+  e.values[2] = value3;
+  e.level = static_cast<int>(level_);
+  e.thread = buffer.thread;
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+unsigned Trace::flush(void){
+  State& s = state();
+  std::vector<Event> events;
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (auto& buffer: s.buffers){
+      const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+      const std::uint64_t capacity = buffer->events.size();
+      if (head - buffer->tail > capacity){  // overwritten before the flush
+        s.dropped += head - buffer->tail - capacity;
+        buffer->tail = head - capacity;
+      }
+      for (; buffer->tail < head; buffer->tail++)
+        events.push_back(buffer->events[buffer->tail % capacity]);
+    }
+  }
+  if (events.empty())
+    return 0;
+  std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b){
+    return a.start < b.start;
+  });
+  if (s.file.empty())
+    for (const auto& e: events)
+      write_text(Rcpp::Rcout, e);
+  else{
+    std::ofstream out(s.file, std::ios::app);
+#ifndef _WIN32
+    const long pid = getpid();
+#else
+    const long pid = 0;
+#endif
+    for (const auto& e: events)
+      write_json(out, e, pid);
+  }
+  s.written += events.size();
+  return events.size();
+}
+
+Rcpp::List Trace::info(void){
+  const State& s = state();
+  return Rcpp::List::create(
+    Rcpp::_("level") = current_level.load(std::memory_order_relaxed),
+    Rcpp::_("file") = s.file,
+    Rcpp::_("capacity") = s.capacity,
+    Rcpp::_("threads") = static_cast<unsigned>(s.buffers.size()),
+    Rcpp::_("written") = static_cast<double>(s.written),
+    Rcpp::_("dropped") = static_cast<double>(s.dropped)
+  );
+}
+
+} // namespace fdpot
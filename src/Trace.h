@@ -0,0 +1,123 @@
+#ifndef TRACE_HH
+#define TRACE_HH
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "RcppArmadillo.h"
+
+namespace fdpot{
+
+/*! @brief Diagnostics of the fits, chosen at run time
+
+ @description Replaces the prints of the debug builds: the code records
+ events (a name and up to three numbers) and spans (the same, timed) at a
+ level, and only the ones at or below the current level are kept. With the
+ level at OFF (the default) an event costs the test of an atomic integer.
+ The events are written in a ring buffer of the thread that records them,
+ without locks nor allocations (the buffer of a thread is allocated once,
+ by its first event); when it is full the oldest events are overwritten and
+ counted as dropped. No I/O happens while recording: flush, called from R's
+ thread once the parallel regions are over (e.g. at the end of
+ FdPot::optimise), collects the events of all the threads in time order and
+ prints them, or appends them to the trace file in the Chrome trace event
+ format (see chrome://tracing or https://ui.perfetto.dev).
+ The names and keys must be string literals: only their address is stored.
+ The events of the worker processes (see ProcessPool) stay in them.
+ */
+class Trace{
+public:
+  /*! @brief the levels, each one includes the previous ones */
+  enum class Level: int{
+    OFF = 0,
+    INFO = 1,  // stages of a fit (features, dissimilarities, set up, restarts)
+    DEBUG = 2,  // each restart, node and feature
+    VERBOSE = 3  // the innermost loops (e.g. each dissimilarity)
+  };
+
+  /*! @brief Sets the level and the output, and discards the events not
+   flushed yet. From R's thread only, with no event being recorded
+   @param level_ the level of the events to keep
+   @param file_ the trace file, truncated; empty to print to the R console
+   @param capacity_ the events each thread keeps before dropping the oldest
+   */
+  static void configure(const Level level_, const std::string& file_ = "",
+                        const unsigned capacity_ = 1u << 14);
+
+  /*! @brief whether the events of a level are recorded */
+  static inline bool on(const Level level_){
+    return static_cast<int>(level_) <= current_level.load(std::memory_order_relaxed);
+  }
+
+  /*! @brief Records an event, if its level is on
+   @param level_ its level
+   @param name what happened (a string literal)
+   @param key1,key2,key3 the names of the values (string literals), or null
+   @param value1,value2,value3 the values
+   */
+  static inline void event(const Level level_, const char* name,
+                           const char* key1 = nullptr, const double value1 = 0.,
+                           const char* key2 = nullptr, const double value2 = 0.,
+                           const char* key3 = nullptr, const double value3 = 0.){
+    if (on(level_))
+      record(level_, name, now(), -1, key1, value1, key2, value2, key3, value3);
+  }
+
+  /*! @brief Times a scope: recorded, if its level is on, when it ends */
+  class Span{
+  public:
+    Span(const Level level_, const char* name_,
+         const char* key1_ = nullptr, const double value1_ = 0.,
+         const char* key2_ = nullptr, const double value2_ = 0.):
+      level(level_), name(name_), key1(key1_), key2(key2_),
+      value1(value1_), value2(value2_), start(on(level_) ? now() : -1) {};
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    /*! @brief a third value, known at the end of the scope (e.g. a status) */
+    inline void set_result(const char* key3_, const double value3_){
+      this->key3 = key3_;
+      this->value3 = value3_;
+    }
+
+    ~Span(){
+      if (this->start >= 0)
+        record(this->level, this->name, this->start, now() - this->start,
+               this->key1, this->value1, this->key2, this->value2,
+               this->key3, this->value3);
+    }
+
+  private:
+    const Level level;
+    const char* name;
+    const char *key1, *key2, *key3 = nullptr;
+    const double value1, value2;
+    double value3 = 0.;
+    const std::int64_t start;  // -1 if not recorded
+  };
+
+  /*! @brief Writes out the events recorded so far, in time order
+   From R's thread only, with no event being recorded (i.e. outside the
+   parallel regions)
+   @return the number of events written
+   */
+  static unsigned flush(void);
+
+  /*! @brief The level, the file, and the events written and dropped */
+  static Rcpp::List info(void);
+
+private:
+  static inline std::atomic<int> current_level{0};
+
+  /*! @brief nanoseconds since the trace was configured */
+  static std::int64_t now(void);
+  static void record(const Level level_, const char* name, const std::int64_t start,
+                     const std::int64_t duration, const char* key1, const double value1,
+                     const char* key2, const double value2, const char* key3,
+                     const double value3);
+};
+
+} // namespace fdpot
+
+#endif
@@ -1,6 +1,12 @@
 #ifndef FDPOT_HELPERS
 #define FDPOT_HELPERS
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 namespace helpers{	
 /**
@@ -58,6 +64,44 @@ inline unsigned n_leaf_nodes(unsigned depth){
   
 }
 
+/**
+ * Hashes bytes with the 64 bit FNV-1a function
+ *
+ * @param data the bytes to hash
+ * @param n_bytes how many
+ * @param hash the hash to continue from, to hash several buffers in a row
+ * @return the hash
+ */
+inline std::uint64_t fnv1a(const void* data, const std::size_t n_bytes,
+                           std::uint64_t hash = 14695981039346656037ull){
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t b = 0; b < n_bytes; b++){
+    hash ^= bytes[b];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * Peak resident memory of the process so far
+ *
+ * @return bytes, NaN where getrusage is not available
+ */
+inline double peak_rss_bytes(void){
+#ifdef _WIN32
+  return std::numeric_limits<double>::quiet_NaN();
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return std::numeric_limits<double>::quiet_NaN();
+#ifdef __APPLE__
+  return static_cast<double>(usage.ru_maxrss);  // bytes
+#else
+  return 1024. * usage.ru_maxrss;  // kilobytes
+#endif
+#endif
+}
+
 } //namespace helpers
 
 #endif 